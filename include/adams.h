@@ -5,6 +5,11 @@ typedef double (*AdamsRSFunc) (double const x,
                                double const *Y,
                                void *userdata);
 
+typedef void (*AdamsSysFunc) (double const x,
+                               double const *Y,
+                               double *DY,
+                               void *userdata);
+
 typedef struct adams_data_st a_data;
 
 int AdamsInitData(a_data **data, unsigned const eq_nums);
@@ -18,12 +23,15 @@ int AdamsSetEquation(a_data *data, AdamsRSFunc func,
                      unsigned const index);
 int AdamsSetEquations(a_data *data, AdamsRSFunc func[],
                       unsigned const num);
+int AdamsSetSystem(a_data *data, AdamsSysFunc func);
 int AdamsCheck(a_data *data);
 void AdamsStep(a_data *data);
+void AdamsStepN(a_data *data, unsigned const n);
 double AdamsGetY(a_data *data, unsigned const num);
 double *AdamsGetYs(a_data *data);
 double AdamsGetX(a_data *data);
 double AdamsGetDY(a_data *data, unsigned const num);
+double *AdamsGetDYs(a_data *data);
 int AdamsSetUserData(a_data *data, void *userdata);
 
 #endif //ADAMS_H
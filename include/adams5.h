@@ -5,6 +5,11 @@ typedef double (*Adams5RSFunc) (double const x,
                                double const *Y,
                                void *userdata);
 
+typedef void (*Adams5SysFunc) (double const x,
+                                double const *Y,
+                                double *DY,
+                                void *userdata);
+
 typedef struct adams5_data_st a5_data;
 
 int Adams5InitData(a5_data **data, unsigned const eq_nums);
@@ -18,12 +23,15 @@ int Adams5SetEquation(a5_data *data, Adams5RSFunc func,
                      unsigned const index);
 int Adams5SetEquations(a5_data *data, Adams5RSFunc func[],
                       unsigned const num);
+int Adams5SetSystem(a5_data *data, Adams5SysFunc func);
 int Adams5Check(a5_data *data);
 void Adams5Step(a5_data *data);
+void Adams5StepN(a5_data *data, unsigned const n);
 double Adams5GetY(a5_data *data, unsigned const num);
 double *Adams5GetYs(a5_data *data);
 double Adams5GetX(a5_data *data);
 double Adams5GetDY(a5_data *data, unsigned const num);
+double *Adams5GetDYs(a5_data *data);
 int Adams5SetUserData(a5_data *data, void *userdata);
 
 #endif //ADAMS5_H
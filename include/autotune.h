@@ -0,0 +1,42 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include "runner.h"
+
+/* Picks the cheapest solver and step for a problem and a target error.
+ * Every solver is probed on the first part of the span with a step and
+ * its half; the Richardson estimate of the global error, scaled up to
+ * the whole span, drives the step to the largest one meeting the
+ * target. The wall time and right side evaluations of the accepted
+ * probe, scaled the same way, rank the solvers. The error norm is the
+ * largest |e_i| / max(1, |y_i|). */
+
+typedef struct autotune_result_st{
+  enum RunnerSolver solver;
+  double h;
+  double error;
+  double seconds;
+  unsigned long evals;
+} autotune_result;
+
+typedef struct autotune_data_st autotune_data;
+
+int AutotuneInitData(autotune_data **data);
+void AutotuneFreeData(autotune_data *data);
+/* Part of the span probed, 0.1 by default. */
+int AutotuneSetProbeSpan(autotune_data *data, double const fraction);
+/* Text file of earlier choices keyed by name, eq_num, span, y0 and
+ * tolerance; a hit skips the probing and misses are appended. */
+int AutotuneSetCache(autotune_data *data, char const *path);
+/* Uses solver-independent fields of problem (eq_num, y0, x0, x_end,
+ * func, userdata); h and stop are ignored. Returns 0 if no solver met
+ * tol. */
+int AutotuneRun(autotune_data *data, runner_job const *problem,
+                char const *name, double const tol, autotune_result *result);
+/* Estimate of one solver from the last probing run; 0 if it failed. */
+int AutotuneGetCandidate(autotune_data *data, enum RunnerSolver const solver,
+                         autotune_result *result);
+/* 1 if the last AutotuneRun was answered from the cache. */
+int AutotuneGetCached(autotune_data *data);
+
+#endif //AUTOTUNE_H
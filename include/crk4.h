@@ -0,0 +1,39 @@
+#ifndef CRK4_H
+#define CRK4_H
+
+#include "complex.h"
+
+typedef double complex (*CRK4RSFunc) (double const x,
+                                      double complex const *Y,
+                                      void *userdata);
+
+typedef void (*CRK4SysFunc) (double const x,
+                             double complex const *Y,
+                             double complex *DY,
+                             void *userdata);
+
+typedef struct crk4_data_st crk4_data;
+
+int CRK4InitData(crk4_data **data, unsigned const eq_nums);
+void CRK4FreeData(crk4_data *data);
+int CRK4SetYs0(crk4_data *data, double complex const ys[],
+               unsigned const num);
+int CRK4SetY0(crk4_data *data, double complex const y, unsigned const index);
+int CRK4SetX(crk4_data *data, double const t);
+int CRK4SetStep(crk4_data *data, double const step);
+int CRK4SetEquation(crk4_data *data, CRK4RSFunc func,
+                    unsigned const index);
+int CRK4SetEquations(crk4_data *data, CRK4RSFunc func[],
+                     unsigned const num);
+int CRK4SetSystem(crk4_data *data, CRK4SysFunc func);
+int CRK4Check(crk4_data *data);
+void CRK4Step(crk4_data *data);
+void CRK4StepN(crk4_data *data, unsigned const n);
+double complex CRK4GetY(crk4_data *data, unsigned const num);
+double complex *CRK4GetYs(crk4_data *data);
+double CRK4GetX(crk4_data *data);
+double complex CRK4GetDY(crk4_data *data, unsigned const num);
+double complex *CRK4GetDYs(crk4_data *data);
+int CRK4SetUserData(crk4_data *data, void *userdata);
+
+#endif //CRK4_H
@@ -0,0 +1,39 @@
+#ifndef CRK5_H
+#define CRK5_H
+
+#include "complex.h"
+
+typedef double complex (*CRK5RSFunc) (double const x,
+                                      double complex const *Y,
+                                      void *userdata);
+
+typedef void (*CRK5SysFunc) (double const x,
+                             double complex const *Y,
+                             double complex *DY,
+                             void *userdata);
+
+typedef struct crk5_data_st crk5_data;
+
+int CRK5InitData(crk5_data **data, unsigned const eq_nums);
+void CRK5FreeData(crk5_data *data);
+int CRK5SetYs0(crk5_data *data, double complex const ys[],
+               unsigned const num);
+int CRK5SetY0(crk5_data *data, double complex const y, unsigned const index);
+int CRK5SetX(crk5_data *data, double const t);
+int CRK5SetStep(crk5_data *data, double const step);
+int CRK5SetEquation(crk5_data *data, CRK5RSFunc func,
+                    unsigned const index);
+int CRK5SetEquations(crk5_data *data, CRK5RSFunc func[],
+                     unsigned const num);
+int CRK5SetSystem(crk5_data *data, CRK5SysFunc func);
+int CRK5Check(crk5_data *data);
+void CRK5Step(crk5_data *data);
+void CRK5StepN(crk5_data *data, unsigned const n);
+double complex CRK5GetY(crk5_data *data, unsigned const num);
+double complex *CRK5GetYs(crk5_data *data);
+double CRK5GetX(crk5_data *data);
+double complex CRK5GetDY(crk5_data *data, unsigned const num);
+double complex *CRK5GetDYs(crk5_data *data);
+int CRK5SetUserData(crk5_data *data, void *userdata);
+
+#endif //CRK5_H
@@ -0,0 +1,44 @@
+#ifndef DDE_H
+#define DDE_H
+
+/* Yd[k*eq_num + i] holds y_i(x - tau_k) for every constant delay tau_k. */
+typedef double (*DDERSFunc) (double const x,
+                             double const *Y,
+                             double const *Yd,
+                             void *userdata);
+
+typedef double (*DDEHistoryFunc) (double const x,
+                                  unsigned const index,
+                                  void *userdata);
+
+typedef struct dde_data_st dde_data;
+
+enum DDEMethod {DDE_RK4, DDE_RK5};
+
+int DDEInitData(dde_data **data, unsigned const eq_nums,
+                unsigned const delay_nums, double const max_delay);
+void DDEFreeData(dde_data *data);
+int DDESetMethod(dde_data *data, enum DDEMethod const method);
+int DDESetYs0(dde_data *data, double const ys[],
+              unsigned const num);
+int DDESetY0(dde_data *data, double const y, unsigned const index);
+int DDESetX(dde_data *data, double const t);
+int DDESetStep(dde_data *data, double const step);
+int DDESetDelay(dde_data *data, double const tau, unsigned const index);
+int DDESetHistory(dde_data *data, DDEHistoryFunc func);
+int DDESetEquation(dde_data *data, DDERSFunc func,
+                   unsigned const index);
+int DDESetEquations(dde_data *data, DDERSFunc func[],
+                    unsigned const num);
+int DDECheck(dde_data *data);
+void DDEStep(dde_data *data);
+double DDEGetY(dde_data *data, unsigned const num);
+double *DDEGetYs(dde_data *data);
+double DDEGetX(dde_data *data);
+double DDEGetDY(dde_data *data, unsigned const num);
+/* y_index(t) for t <= x + h; usable for state dependent delays. NaN
+ * for t older than the retained past, x - max_delay - h. */
+double DDEGetDelayed(dde_data *data, double const t, unsigned const index);
+int DDESetUserData(dde_data *data, void *userdata);
+
+#endif //DDE_H
@@ -0,0 +1,40 @@
+#ifndef DIST_H
+#define DIST_H
+
+#include <mpi.h>
+
+/* Fills DY[first..last) of the local slice. Y is indexed by local row
+ * (use a signed index): Y[-halo..-1] and Y[count..count + halo - 1] hold
+ * neighbour values, zero at non periodic domain ends. */
+typedef void (*DistSysFunc) (double const x,
+                             double const *Y,
+                             double *DY,
+                             unsigned const first,
+                             unsigned const last,
+                             void *userdata);
+
+typedef struct dist_data_st dist_data;
+
+int DistInitData(dist_data **data, MPI_Comm comm, unsigned const eq_nums,
+                 unsigned const halo);
+void DistFreeData(dist_data *data);
+unsigned DistGetFirst(dist_data *data);
+unsigned DistGetCount(dist_data *data);
+int DistSetYs0(dist_data *data, double const ys[],
+               unsigned const num);
+int DistSetX(dist_data *data, double const t);
+int DistSetStep(dist_data *data, double const step);
+int DistSetTolerance(dist_data *data, double const atol, double const rtol);
+int DistSetPeriodic(dist_data *data, int const periodic);
+int DistSetSystem(dist_data *data, DistSysFunc func);
+int DistCheck(dist_data *data);
+/* With a tolerance returns 0 on every rank, leaving the state and step
+ * unchanged, when no step is accepted after repeated rejections, e.g.
+ * when the right side yields NaN. */
+int DistStep(dist_data *data);
+double *DistGetYs(dist_data *data);
+double DistGetX(dist_data *data);
+double DistGetStep(dist_data *data);
+int DistSetUserData(dist_data *data, void *userdata);
+
+#endif //DIST_H
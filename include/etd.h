@@ -0,0 +1,47 @@
+#ifndef ETD_H
+#define ETD_H
+
+/* y' = L y + N(x, y) with a stiff linear part L and a mild nonlinear
+ * part N, integrated by the exponential time differencing RK4 scheme of
+ * Cox and Matthews. */
+typedef void (*ETDNonlinFunc) (double const x,
+                               double const *Y,
+                               double *N,
+                               void *userdata);
+
+/* LV = L V */
+typedef void (*ETDMatvecFunc) (double const *V,
+                               double *LV,
+                               void *userdata);
+
+typedef struct etd_data_st etd_data;
+
+int ETDInitData(etd_data **data, unsigned const eq_nums);
+void ETDFreeData(etd_data *data);
+int ETDSetYs0(etd_data *data, double const ys[],
+              unsigned const num);
+int ETDSetY0(etd_data *data, double const y, unsigned const index);
+int ETDSetX(etd_data *data, double const t);
+int ETDSetStep(etd_data *data, double const step);
+/* L is given by one of the three setters below. For diagonal and dense
+ * L the phi functions of h L are computed once per step size. */
+int ETDSetDiagonal(etd_data *data, double const l[], unsigned const num);
+/* Row major, num = eq_nums * eq_nums. */
+int ETDSetDense(etd_data *data, double const l[], unsigned const num);
+/* Phi function actions are then computed by Krylov projection. */
+int ETDSetMatvec(etd_data *data, ETDMatvecFunc func);
+/* Krylov dimension (default 30) and relative tolerance (default 1e-10). */
+int ETDSetKrylov(etd_data *data, unsigned const dim, double const tol);
+int ETDSetNonlinear(etd_data *data, ETDNonlinFunc func);
+int ETDCheck(etd_data *data);
+/* Returns 0, leaving y and x unchanged, if the phi functions cannot be
+ * computed, e.g. when the Krylov projection meets a NaN from the
+ * nonlinear part. StepN stops at the first such step. */
+int ETDStep(etd_data *data);
+int ETDStepN(etd_data *data, unsigned const n);
+double ETDGetY(etd_data *data, unsigned const num);
+double *ETDGetYs(etd_data *data);
+double ETDGetX(etd_data *data);
+int ETDSetUserData(etd_data *data, void *userdata);
+
+#endif //ETD_H
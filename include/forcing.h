@@ -0,0 +1,30 @@
+#ifndef FORCING_H
+#define FORCING_H
+
+#include "stddef.h"
+
+/* Tabulated forcing input: rows of (x, v_1, ..., v_channels) doubles
+ * with strictly increasing x. Lookups keep a cursor on the last
+ * segment, so the slowly advancing x of an integration costs O(1)
+ * amortized per call. Outside the table the end values are held. An
+ * object is not thread safe; open one per thread. */
+
+enum ForcingInterp {FORCING_LINEAR, FORCING_CUBIC, FORCING_AKIMA};
+
+typedef struct forcing_data_st forcing_data;
+
+/* Maps a raw native-endian file of rows read-only. */
+int ForcingInitFile(forcing_data **data, char const *path,
+                    unsigned const channels);
+/* Uses a table in memory without copying it. */
+int ForcingInitTable(forcing_data **data, double const *table,
+                     size_t const rows, unsigned const channels);
+void ForcingFreeData(forcing_data *data);
+/* FORCING_CUBIC is the local cubic Hermite with centered slopes. */
+int ForcingSetInterp(forcing_data *data, enum ForcingInterp const interp);
+double ForcingGet(forcing_data *data, double const x, unsigned const channel);
+/* All channels at x into values. */
+int ForcingGets(forcing_data *data, double const x, double *values);
+size_t ForcingGetRows(forcing_data *data);
+
+#endif //FORCING_H
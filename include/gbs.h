@@ -0,0 +1,37 @@
+#ifndef GBS_H
+#define GBS_H
+
+typedef double (*GBSRSFunc) (double const x,
+                             double const *Y,
+                             void *userdata);
+
+typedef struct gbs_data_st gbs_data;
+
+int GBSInitData(gbs_data **data, unsigned const eq_nums);
+void GBSFreeData(gbs_data *data);
+int GBSSetYs0(gbs_data *data, double const ys[],
+              unsigned const num);
+int GBSSetY0(gbs_data *data, double const y, unsigned const index);
+int GBSSetX(gbs_data *data, double const t);
+int GBSSetStep(gbs_data *data, double const step);
+int GBSSetTolerance(gbs_data *data, double const atol, double const rtol);
+int GBSSetThreads(gbs_data *data, unsigned const threads);
+int GBSSetEquation(gbs_data *data, GBSRSFunc func,
+                   unsigned const index);
+int GBSSetEquations(gbs_data *data, GBSRSFunc func[],
+                    unsigned const num);
+int GBSCheck(gbs_data *data);
+/* One accepted step; step size and order adapt to the tolerance.
+ * Returns 0 with the state unchanged if no step is accepted after
+ * repeated rejections, e.g. when the right side yields NaN. */
+int GBSStep(gbs_data *data);
+int GBSIntegrate(gbs_data *data, double const x_end);
+double GBSGetY(gbs_data *data, unsigned const num);
+double *GBSGetYs(gbs_data *data);
+double GBSGetX(gbs_data *data);
+double GBSGetDY(gbs_data *data, unsigned const num);
+double GBSGetStep(gbs_data *data);
+unsigned GBSGetOrder(gbs_data *data);
+int GBSSetUserData(gbs_data *data, void *userdata);
+
+#endif //GBS_H
@@ -0,0 +1,39 @@
+#ifndef LINEAR_H
+#define LINEAR_H
+
+#include "pool.h"
+
+/* Fills the forcing vector B = b(x) of y' = A y + b(x). */
+typedef void (*LinearForceFunc) (double const x,
+                                 double *B,
+                                 void *userdata);
+
+typedef struct linear_data_st linear_data;
+
+int LinearInitData(linear_data **data, unsigned const eq_nums);
+void LinearFreeData(linear_data *data);
+/* A in CSR form: row i holds vals[row_ptr[i]..row_ptr[i+1]) in columns
+ * cols[...]. The arrays are copied; cols and vals may be NULL only
+ * when A has no entries. */
+int LinearSetMatrix(linear_data *data, unsigned const row_ptr[],
+                    unsigned const cols[], double const vals[]);
+int LinearSetForce(linear_data *data, LinearForceFunc func);
+int LinearSetYs0(linear_data *data, double const ys[],
+                 unsigned const num);
+int LinearSetY0(linear_data *data, double const y, unsigned const index);
+int LinearSetX(linear_data *data, double const t);
+int LinearSetStep(linear_data *data, double const step);
+/* Rows are split over the pool threads in blocks of equal nonzeros; NULL
+ * steps serially. */
+int LinearSetPool(linear_data *data, pool_data *pool);
+int LinearCheck(linear_data *data);
+void LinearStep(linear_data *data);
+void LinearStepN(linear_data *data, unsigned const n);
+double LinearGetY(linear_data *data, unsigned const num);
+double *LinearGetYs(linear_data *data);
+double LinearGetX(linear_data *data);
+double LinearGetDY(linear_data *data, unsigned const num);
+double *LinearGetDYs(linear_data *data);
+int LinearSetUserData(linear_data *data, void *userdata);
+
+#endif //LINEAR_H
@@ -0,0 +1,25 @@
+#ifndef OBSERVER_H
+#define OBSERVER_H
+
+#include <stdio.h>
+
+typedef struct observer_data_st obs_data;
+
+/* Behaviour of ObserverPush when the ring is full. */
+enum ObserverPolicy {OBSERVER_BLOCK, OBSERVER_DROP, OBSERVER_DECIMATE};
+
+int ObserverInitData(obs_data **data, unsigned const eq_nums,
+                     unsigned const capacity);
+void ObserverFreeData(obs_data *data);
+int ObserverSetPolicy(obs_data *data, enum ObserverPolicy const policy);
+int ObserverSetOutput(obs_data *data, FILE *out);
+int ObserverStart(obs_data *data);
+/* Returns 1 when the record is queued, 0 when the policy dropped or
+ * decimated it (OBSERVER_DROP, OBSERVER_DECIMATE) and -1 for invalid
+ * arguments or an observer that is not started. */
+int ObserverPush(obs_data *data, double const x, double const *ys);
+int ObserverStop(obs_data *data);
+unsigned long ObserverGetWritten(obs_data *data);
+unsigned long ObserverGetDropped(obs_data *data);
+
+#endif //OBSERVER_H
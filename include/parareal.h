@@ -0,0 +1,42 @@
+#ifndef PARAREAL_H
+#define PARAREAL_H
+
+typedef double (*PararealRSFunc) (double const x,
+                                  double const *Y,
+                                  void *userdata);
+
+typedef struct parareal_data_st pr_data;
+
+enum PararealFine {PARAREAL_FINE_RK5, PARAREAL_FINE_ADAMS5};
+
+int PararealInitData(pr_data **data, unsigned const eq_nums,
+                     unsigned const slices);
+void PararealFreeData(pr_data *data);
+int PararealSetYs0(pr_data *data, double const ys[],
+                   unsigned const num);
+int PararealSetY0(pr_data *data, double const y, unsigned const index);
+int PararealSetX(pr_data *data, double const t);
+int PararealSetXEnd(pr_data *data, double const t);
+int PararealSetCoarseStep(pr_data *data, double const step);
+int PararealSetFineStep(pr_data *data, double const step);
+int PararealSetFineMethod(pr_data *data, enum PararealFine const method);
+int PararealSetEquation(pr_data *data, PararealRSFunc func,
+                        unsigned const index);
+int PararealSetEquations(pr_data *data, PararealRSFunc func[],
+                         unsigned const num);
+int PararealSetTolerance(pr_data *data, double const tol);
+int PararealSetMaxIterations(pr_data *data, unsigned const iters);
+int PararealSetThreads(pr_data *data, unsigned const threads);
+int PararealCheck(pr_data *data);
+/* Right sides are called concurrently from several threads. */
+int PararealSolve(pr_data *data);
+double PararealGetY(pr_data *data, unsigned const num);
+double *PararealGetYs(pr_data *data);
+double *PararealGetSliceYs(pr_data *data, unsigned const slice);
+double PararealGetX(pr_data *data);
+unsigned PararealGetIterations(pr_data *data);
+int PararealIsConverged(pr_data *data);
+double PararealGetSpeedup(pr_data *data);
+int PararealSetUserData(pr_data *data, void *userdata);
+
+#endif //PARAREAL_H
@@ -0,0 +1,22 @@
+#ifndef POOL_H
+#define POOL_H
+
+typedef void (*PoolTaskFunc) (unsigned const task,
+                              unsigned const thread,
+                              void *arg);
+
+typedef struct pool_data_st pool_data;
+
+int PoolInitData(pool_data **data, unsigned const threads);
+void PoolFreeData(pool_data *data);
+int PoolRun(pool_data *data, PoolTaskFunc func, unsigned const tasks,
+            void *arg);
+int PoolRunStatic(pool_data *data, PoolTaskFunc func, unsigned const tasks,
+                  void *arg);
+/* Pins pool thread i (0 is the caller) to cpus[i % num]. The caller's
+ * mask from before the first call is restored by PoolFreeData, which
+ * must run while that thread is still alive. */
+int PoolSetAffinity(pool_data *data, int const cpus[], unsigned const num);
+unsigned PoolGetThreads(pool_data *data);
+
+#endif //POOL_H
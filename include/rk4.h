@@ -1,12 +1,30 @@
 #ifndef RK4_H
 #define RK4_H
 
+#include "pool.h"
+
 typedef double (*RK4RSFunc) (double const x,
                                double const *Y,
                                void *userdata);
 
+typedef void (*RK4SysFunc) (double const x,
+                            double const *Y,
+                            double *DY,
+                            void *userdata);
+
+/* Fills DY[first..last) only; used for threaded stepping. */
+typedef void (*RK4RangeFunc) (double const x,
+                              double const *Y,
+                              double *DY,
+                              unsigned const first,
+                              unsigned const last,
+                              void *userdata);
+
 typedef struct rk4_data_st rk_data;
 
+/* Rate class of an equation for multirate stepping (see RK4SetSubsteps). */
+enum RK4Rate {RK4_RATE_SLOW, RK4_RATE_FAST};
+
 int RK4InitData(rk_data **data, unsigned const eq_nums);
 void RK4FreeData(rk_data *data);
 int RK4SetYs0(rk_data *data, double const ys[],
@@ -18,12 +36,29 @@ int RK4SetEquation(rk_data *data, RK4RSFunc func,
                      unsigned const index);
 int RK4SetEquations(rk_data *data, RK4RSFunc func[],
                       unsigned const num);
+/* A system right side fills all of DY at once and overrides funcs. */
+int RK4SetSystem(rk_data *data, RK4SysFunc func);
+int RK4SetRangeSystem(rk_data *data, RK4RangeFunc func);
+/* Threaded stepping: partition t of y, dy and the stage buffers is first
+ * touched and then advanced by pool thread t only, so on NUMA nodes it
+ * stays in the memory of the socket that thread is pinned to
+ * (PoolSetAffinity). The buffers are reallocated for that, which
+ * invalidates pointers returned by RK4GetYs and RK4GetDYs before the
+ * call. The pool must outlive its use by the solver; NULL detaches it
+ * and returns to serial stepping, keeping the buffers. */
+int RK4SetPool(rk_data *data, pool_data *pool);
+int RK4SetEquationRate(rk_data *data, enum RK4Rate const rate,
+                       unsigned const index);
+/* substeps > 1: fast equations take substeps of h/substeps per RK4Step. */
+int RK4SetSubsteps(rk_data *data, unsigned const substeps);
 int RK4Check(rk_data *data);
 void RK4Step(rk_data *data);
+void RK4StepN(rk_data *data, unsigned const n);
 double RK4GetY(rk_data *data, unsigned const num);
 double *RK4GetYs(rk_data *data);
 double RK4GetX(rk_data *data);
 double RK4GetDY(rk_data *data, unsigned const num);
+double *RK4GetDYs(rk_data *data);
 int RK4SetUserData(rk_data *data, void *userdata);
 
 #endif //RK4_H
@@ -5,6 +5,11 @@ typedef double (*RK5RSFunc) (double const x,
                                double const *Y,
                                void *userdata);
 
+typedef void (*RK5SysFunc) (double const x,
+                             double const *Y,
+                             double *DY,
+                             void *userdata);
+
 typedef struct rk5_data_st rk5_data;
 
 int RK5InitData(rk5_data **data, unsigned const eq_nums);
@@ -18,12 +23,15 @@ int RK5SetEquation(rk5_data *data, RK5RSFunc func,
                      unsigned const index);
 int RK5SetEquations(rk5_data *data, RK5RSFunc func[],
                       unsigned const num);
+int RK5SetSystem(rk5_data *data, RK5SysFunc func);
 int RK5Check(rk5_data *data);
 void RK5Step(rk5_data *data);
+void RK5StepN(rk5_data *data, unsigned const n);
 double RK5GetY(rk5_data *data, unsigned const num);
 double *RK5GetYs(rk5_data *data);
 double RK5GetX(rk5_data *data);
 double RK5GetDY(rk5_data *data, unsigned const num);
+double *RK5GetDYs(rk5_data *data);
 int RK5SetUserData(rk5_data *data, void *userdata);
 
 #endif //RK5_H
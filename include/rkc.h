@@ -0,0 +1,46 @@
+#ifndef RKC_H
+#define RKC_H
+
+typedef double (*RKCRSFunc) (double const x,
+                             double const *Y,
+                             void *userdata);
+
+typedef void (*RKCSysFunc) (double const x,
+                            double const *Y,
+                            double *DY,
+                            void *userdata);
+
+/* Upper bound of the spectral radius of the Jacobian at (x, Y). */
+typedef double (*RKCRadiusFunc) (double const x,
+                                 double const *Y,
+                                 void *userdata);
+
+typedef struct rkc_data_st rkc_data;
+
+int RKCInitData(rkc_data **data, unsigned const eq_nums);
+void RKCFreeData(rkc_data *data);
+int RKCSetYs0(rkc_data *data, double const ys[],
+              unsigned const num);
+int RKCSetY0(rkc_data *data, double const y, unsigned const index);
+int RKCSetX(rkc_data *data, double const t);
+int RKCSetStep(rkc_data *data, double const step);
+int RKCSetEquation(rkc_data *data, RKCRSFunc func,
+                   unsigned const index);
+int RKCSetEquations(rkc_data *data, RKCRSFunc func[],
+                    unsigned const num);
+int RKCSetSystem(rkc_data *data, RKCSysFunc func);
+/* Without it the radius is estimated by power iteration on difference
+ * quotients of the right side, refreshed every `period` steps. */
+int RKCSetSpectralRadius(rkc_data *data, RKCRadiusFunc func);
+int RKCSetRadiusPeriod(rkc_data *data, unsigned const period);
+int RKCCheck(rkc_data *data);
+void RKCStep(rkc_data *data);
+void RKCStepN(rkc_data *data, unsigned const n);
+double RKCGetY(rkc_data *data, unsigned const num);
+double *RKCGetYs(rkc_data *data);
+double RKCGetX(rkc_data *data);
+double RKCGetSpectralRadius(rkc_data *data);
+unsigned RKCGetStages(rkc_data *data);
+int RKCSetUserData(rkc_data *data, void *userdata);
+
+#endif //RKC_H
@@ -0,0 +1,50 @@
+#ifndef RKN_H
+#define RKN_H
+
+/* Right side of y'' = f(x, y). */
+typedef double (*RKNRSFunc) (double const x,
+                             double const *Y,
+                             void *userdata);
+
+typedef void (*RKNSysFunc) (double const x,
+                            double const *Y,
+                            double *DDY,
+                            void *userdata);
+
+typedef struct rkn_data_st rkn_data;
+
+/* RKN_5 adapts its step when a tolerance is set. */
+enum RKNMethod {RKN_4, RKN_5};
+
+int RKNInitData(rkn_data **data, unsigned const eq_nums);
+void RKNFreeData(rkn_data *data);
+int RKNSetMethod(rkn_data *data, enum RKNMethod const method);
+int RKNSetYs0(rkn_data *data, double const ys[],
+              unsigned const num);
+int RKNSetY0(rkn_data *data, double const y, unsigned const index);
+int RKNSetDYs0(rkn_data *data, double const dys[],
+               unsigned const num);
+int RKNSetDY0(rkn_data *data, double const dy, unsigned const index);
+int RKNSetX(rkn_data *data, double const t);
+int RKNSetStep(rkn_data *data, double const step);
+int RKNSetTolerance(rkn_data *data, double const atol, double const rtol);
+int RKNSetEquation(rkn_data *data, RKNRSFunc func,
+                   unsigned const index);
+int RKNSetEquations(rkn_data *data, RKNRSFunc func[],
+                    unsigned const num);
+int RKNSetSystem(rkn_data *data, RKNSysFunc func);
+int RKNCheck(rkn_data *data);
+/* RKN_5 with a tolerance returns 0, leaving y, y', x and h unchanged,
+ * when no step is accepted after repeated rejections, e.g. when the
+ * right side yields NaN. StepN stops at the first such step. */
+int RKNStep(rkn_data *data);
+int RKNStepN(rkn_data *data, unsigned const n);
+double RKNGetY(rkn_data *data, unsigned const num);
+double *RKNGetYs(rkn_data *data);
+double RKNGetDY(rkn_data *data, unsigned const num);
+double *RKNGetDYs(rkn_data *data);
+double RKNGetX(rkn_data *data);
+double RKNGetStep(rkn_data *data);
+int RKNSetUserData(rkn_data *data, void *userdata);
+
+#endif //RKN_H
@@ -0,0 +1,50 @@
+#ifndef RUNNER_H
+#define RUNNER_H
+
+typedef void (*RunnerSysFunc) (double const x,
+                               double const *Y,
+                               double *DY,
+                               void *userdata);
+
+/* Nonzero ends the job after the step that reached (x, Y). */
+typedef int (*RunnerStopFunc) (double const x,
+                               double const *Y,
+                               void *userdata);
+
+enum RunnerSolver {RUNNER_RK4, RUNNER_RK5, RUNNER_ADAMS, RUNNER_ADAMS5,
+                   RUNNER_SOLVERS};
+
+/* One independent problem. The runner fills the fields after userdata:
+ * y (eq_num values, may be NULL), the x reached, the number of steps
+ * and status, 1 on success. */
+typedef struct runner_job_st{
+  enum RunnerSolver solver;
+  unsigned eq_num;
+  double const *y0;
+  double x0;
+  double x_end;
+  double h;
+  RunnerSysFunc func;
+  RunnerStopFunc stop;
+  void *userdata;
+  double *y;
+  double x;
+  unsigned long steps;
+  int status;
+} runner_job;
+
+typedef struct runner_data_st runner_data;
+
+int RunnerInitData(runner_data **data, unsigned const threads);
+void RunnerFreeData(runner_data *data);
+/* Runs all jobs and returns when the last one is done. Each thread
+ * starts with a contiguous share of the jobs and, once out of work,
+ * steals half of the remaining jobs of another thread. Solver objects
+ * are kept per thread and reused across jobs and calls. Returns 1 if
+ * every job succeeded. */
+int RunnerRun(runner_data *data, runner_job jobs[], unsigned const num);
+unsigned RunnerGetThreads(runner_data *data);
+/* Steals made by the last RunnerRun. */
+unsigned long RunnerGetSteals(runner_data *data);
+
+#endif //RUNNER_H
@@ -0,0 +1,52 @@
+#ifndef SDE_H
+#define SDE_H
+
+#include "stdint.h"
+
+/* dY = A(x, Y) dx + B(x, Y) dW with diagonal noise: component i is
+ * driven by its own Wiener process W_i with coefficient B[i]. */
+typedef void (*SDEDriftFunc) (double const x,
+                              double const *Y,
+                              double *A,
+                              void *userdata);
+
+typedef void (*SDEDiffusionFunc) (double const x,
+                                  double const *Y,
+                                  double *B,
+                                  void *userdata);
+
+typedef struct sde_data_st sde_data;
+
+/* Strong orders 0.5, 1 and 1.5. SDE_MILSTEIN is the derivative free
+ * variant; SDE_SRA1 requires additive noise (B independent of Y). */
+enum SDEMethod {SDE_EULER_MARUYAMA, SDE_MILSTEIN, SDE_SRA1};
+
+int SDEInitData(sde_data **data, unsigned const eq_nums);
+void SDEFreeData(sde_data *data);
+int SDESetMethod(sde_data *data, enum SDEMethod const method);
+int SDESetYs0(sde_data *data, double const ys[],
+              unsigned const num);
+int SDESetY0(sde_data *data, double const y, unsigned const index);
+int SDESetX(sde_data *data, double const t);
+int SDESetStep(sde_data *data, double const step);
+int SDESetDrift(sde_data *data, SDEDriftFunc func);
+int SDESetDiffusion(sde_data *data, SDEDiffusionFunc func);
+/* Selects the random stream; it depends on (seed, path) only, so paths
+ * of an ensemble can be spread over threads in any order. Also resets
+ * the Wiener paths to 0. */
+int SDESetStream(sde_data *data, uint32_t const seed, uint32_t const path);
+int SDECheck(sde_data *data);
+void SDEStep(sde_data *data);
+void SDEStepN(sde_data *data, unsigned const n);
+double SDEGetY(sde_data *data, unsigned const num);
+double *SDEGetYs(sde_data *data);
+double SDEGetX(sde_data *data);
+/* W_index(x) - W_index(x0) along the current path. */
+double SDEGetW(sde_data *data, unsigned const num);
+int SDESetUserData(sde_data *data, void *userdata);
+
+/* Philox4x32-10 counter based generator. */
+void SDEPhilox(uint32_t const ctr[4], uint32_t const key[2],
+               uint32_t out[4]);
+
+#endif //SDE_H
@@ -0,0 +1,37 @@
+#ifndef SENS_H
+#define SENS_H
+
+typedef void (*SensSysFunc) (double const x,
+                             double const *Y,
+                             double *DY,
+                             void *userdata);
+
+/* DS = df/dY * S + df/dp[param] for one sensitivity column S. */
+typedef void (*SensJVPFunc) (double const x,
+                             double const *Y,
+                             double const *S,
+                             unsigned const param,
+                             double *DS,
+                             void *userdata);
+
+typedef struct sens_data_st sens_data;
+
+int SensInitData(sens_data **data, unsigned const eq_nums,
+                 unsigned const param_nums);
+void SensFreeData(sens_data *data);
+int SensSetSystem(sens_data *data, SensSysFunc func);
+int SensSetJVP(sens_data *data, SensJVPFunc func);
+int SensSetParams(sens_data *data, double *params);
+int SensSetUserData(sens_data *data, void *userdata);
+int SensCheck(sens_data *data);
+unsigned SensGetSize(sens_data *data);
+int SensInitState(sens_data *data, double const ys[], double const ss[],
+                  double *Z);
+/* Augmented right side; pass to XSetSystem with the sens_data as userdata. */
+void SensRightSide(double const x, double const *Z, double *DZ,
+                   void *userdata);
+double SensGetS(sens_data *data, double const *Z, unsigned const eq,
+                unsigned const param);
+double const *SensGetSs(sens_data *data, double const *Z);
+
+#endif //SENS_H
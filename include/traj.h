@@ -0,0 +1,26 @@
+#ifndef TRAJ_H
+#define TRAJ_H
+
+#include "stddef.h"
+
+/* Compressed trajectory files: steps (x, y_0 .. y_n-1) are stored in
+ * independently compressed blocks of block_steps steps followed by a
+ * block index, so any step can be read back without decoding the file
+ * up to it. */
+
+typedef struct traj_data_st traj_data;
+
+/* Up to `threads` full blocks are compressed in parallel. */
+int TrajInitWriter(traj_data **data, char const *path, unsigned const eq_nums,
+                   unsigned const block_steps, unsigned const threads);
+int TrajPush(traj_data *data, double const x, double const *ys);
+/* Writes the pending blocks and the index; returns 0 on I/O errors. */
+int TrajClose(traj_data *data);
+int TrajInitReader(traj_data **data, char const *path);
+int TrajRead(traj_data *data, size_t const step, double *x, double *ys);
+unsigned TrajGetEqNum(traj_data *data);
+size_t TrajGetSteps(traj_data *data);
+/* Closes a writer that was not closed yet. */
+void TrajFreeData(traj_data *data);
+
+#endif //TRAJ_H
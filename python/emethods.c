@@ -0,0 +1,350 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+#include "math.h"
+#include "rk4.h"
+#include "rk5.h"
+#include "adams.h"
+#include "adams5.h"
+
+/* CPython binding for the fixed-step solvers. y and dy are exposed as
+ * NumPy views of the solver buffers, the right side is either one
+ * vectorized Python callable f(x, y, dy) filling dy in place or the
+ * address of a compiled void f(double, const double *, double *, void *)
+ * (cffi, Numba cfunc, ctypes). Stepping always runs with the GIL
+ * released; a Python right side retakes it for the duration of a call. */
+
+typedef void (*SysFunc) (double const x, double const *Y, double *DY,
+                         void *userdata);
+
+struct solver_ops{
+  char const *name;
+  int (*init)(void **data, unsigned const eq_num);
+  void (*free)(void *data);
+  int (*set_x)(void *data, double const x);
+  int (*set_step)(void *data, double const h);
+  int (*set_system)(void *data, SysFunc func);
+  int (*set_userdata)(void *data, void *userdata);
+  int (*check)(void *data);
+  void (*step)(void *data);
+  void (*step_n)(void *data, unsigned const n);
+  double *(*get_ys)(void *data);
+  double *(*get_dys)(void *data);
+  double (*get_x)(void *data);
+};
+
+#define SOLVER_OPS(PFX, T, NAME)                                          \
+  static int PFX##OpInit(void **data, unsigned const eq_num){             \
+    T *d;                                                                 \
+    int res = PFX##InitData(&d, eq_num);                                  \
+    *data = d;                                                            \
+    return res;                                                           \
+  }                                                                       \
+  static void PFX##OpFree(void *data){ PFX##FreeData(data); }             \
+  static int PFX##OpSetX(void *data, double const x){                     \
+    return PFX##SetX(data, x);                                            \
+  }                                                                       \
+  static int PFX##OpSetStep(void *data, double const h){                  \
+    return PFX##SetStep(data, h);                                         \
+  }                                                                       \
+  static int PFX##OpSetSystem(void *data, SysFunc func){                  \
+    return PFX##SetSystem(data, func);                                    \
+  }                                                                       \
+  static int PFX##OpSetUserData(void *data, void *userdata){              \
+    return PFX##SetUserData(data, userdata);                              \
+  }                                                                       \
+  static int PFX##OpCheck(void *data){ return PFX##Check(data); }         \
+  static void PFX##OpStep(void *data){ PFX##Step(data); }                 \
+  static void PFX##OpStepN(void *data, unsigned const n){                 \
+    PFX##StepN(data, n);                                                  \
+  }                                                                       \
+  static double *PFX##OpGetYs(void *data){ return PFX##GetYs(data); }     \
+  static double *PFX##OpGetDYs(void *data){ return PFX##GetDYs(data); }   \
+  static double PFX##OpGetX(void *data){ return PFX##GetX(data); }        \
+  static struct solver_ops const PFX##Ops = {                             \
+    NAME, PFX##OpInit, PFX##OpFree, PFX##OpSetX, PFX##OpSetStep,          \
+    PFX##OpSetSystem, PFX##OpSetUserData, PFX##OpCheck, PFX##OpStep,      \
+    PFX##OpStepN, PFX##OpGetYs, PFX##OpGetDYs, PFX##OpGetX                \
+  };
+
+SOLVER_OPS(RK4, rk_data, "rk4")
+SOLVER_OPS(RK5, rk5_data, "rk5")
+SOLVER_OPS(Adams, a_data, "adams")
+SOLVER_OPS(Adams5, a5_data, "adams5")
+
+static struct solver_ops const *const SOLVERS[] = {
+  &RK4Ops, &RK5Ops, &AdamsOps, &Adams5Ops
+};
+
+typedef struct{
+  PyObject_HEAD
+  struct solver_ops const *ops;
+  void *data;
+  npy_intp eq_num;
+  PyObject *rhs;
+  SysFunc cfunc;
+  double h;
+  int failed;
+} SolverObject;
+
+static void PySystem(double const x, double const *Y, double *DY,
+                     void *userdata){
+  SolverObject *self = userdata;
+  PyGILState_STATE state = PyGILState_Ensure();
+  if(!self->failed){
+    /* Y and DY are stage buffers of the step, so the callable gets
+     * copies it may keep; dy is copied back after the call. */
+    size_t size = sizeof(double)*self->eq_num;
+    PyObject *y = PyArray_SimpleNew(1, &self->eq_num, NPY_DOUBLE);
+    PyObject *dy = PyArray_ZEROS(1, &self->eq_num, NPY_DOUBLE, 0);
+    PyObject *res = NULL;
+    if(y && dy){
+      memcpy(PyArray_DATA((PyArrayObject *)y), Y, size);
+      PyArray_CLEARFLAGS((PyArrayObject *)y, NPY_ARRAY_WRITEABLE);
+      res = PyObject_CallFunction(self->rhs, "dOO", x, y, dy);
+    }
+    if(res){
+      memcpy(DY, PyArray_DATA((PyArrayObject *)dy), size);
+    }
+    self->failed = !res;
+    Py_XDECREF(res);
+    Py_XDECREF(dy);
+    Py_XDECREF(y);
+  }
+  if(self->failed){
+    for(npy_intp i = 0; i < self->eq_num; i++){
+      DY[i] = NAN;
+    }
+  }
+  PyGILState_Release(state);
+}
+
+static PyObject *SolverView(SolverObject *self, double *buf){
+  PyObject *arr = PyArray_SimpleNewFromData(1, &self->eq_num, NPY_DOUBLE,
+                                            buf);
+  if(!arr){
+    return NULL;
+  }
+  Py_INCREF(self);
+  if(PyArray_SetBaseObject((PyArrayObject *)arr, (PyObject *)self) < 0){
+    Py_DECREF(arr);
+    return NULL;
+  }
+  return arr;
+}
+
+static int Solver_init(SolverObject *self, PyObject *args, PyObject *kwds){
+  static char *kwlist[] = {"method", "eq_num", NULL};
+  char const *method;
+  unsigned eq_num;
+  if(!PyArg_ParseTupleAndKeywords(args, kwds, "sI", kwlist,
+                                  &method, &eq_num)){
+    return -1;
+  }
+  if(self->data){
+    PyErr_SetString(PyExc_RuntimeError, "solver already initialized");
+    return -1;
+  }
+  for(size_t i = 0; i < sizeof(SOLVERS)/sizeof(SOLVERS[0]); i++){
+    if(!strcmp(method, SOLVERS[i]->name)){
+      self->ops = SOLVERS[i];
+    }
+  }
+  if(!self->ops){
+    PyErr_Format(PyExc_ValueError, "unknown method '%s'", method);
+    return -1;
+  }
+  if(!eq_num || !self->ops->init(&self->data, eq_num)){
+    PyErr_SetString(PyExc_MemoryError, "solver initialization failed");
+    return -1;
+  }
+  self->eq_num = eq_num;
+  return 0;
+}
+
+static void Solver_dealloc(SolverObject *self){
+  if(self->ops){
+    self->ops->free(self->data);
+  }
+  Py_XDECREF(self->rhs);
+  Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+#define SOLVER_READY(self)                                                \
+  if(!(self)->data){                                                      \
+    PyErr_SetString(PyExc_RuntimeError, "solver not initialized");        \
+    return NULL;                                                          \
+  }
+
+static PyObject *Solver_set_rhs(SolverObject *self, PyObject *args){
+  PyObject *rhs;
+  unsigned long long userdata = 0;
+  SOLVER_READY(self);
+  if(!PyArg_ParseTuple(args, "O|K", &rhs, &userdata)){
+    return NULL;
+  }
+  Py_CLEAR(self->rhs);
+  self->cfunc = NULL;
+  if(PyLong_Check(rhs)){
+    self->cfunc = (SysFunc)(uintptr_t)PyLong_AsUnsignedLongLong(rhs);
+    if(PyErr_Occurred() || !self->cfunc){
+      PyErr_SetString(PyExc_ValueError, "invalid function address");
+      return NULL;
+    }
+    self->ops->set_system(self->data, self->cfunc);
+    self->ops->set_userdata(self->data, (void *)(uintptr_t)userdata);
+  } else if(PyCallable_Check(rhs)){
+    Py_INCREF(rhs);
+    self->rhs = rhs;
+    self->ops->set_system(self->data, PySystem);
+    self->ops->set_userdata(self->data, self);
+  } else {
+    PyErr_SetString(PyExc_TypeError,
+                    "rhs must be callable or a C function address");
+    return NULL;
+  }
+  Py_RETURN_NONE;
+}
+
+static PyObject *Solver_set_x(SolverObject *self, PyObject *args){
+  double x;
+  SOLVER_READY(self);
+  if(!PyArg_ParseTuple(args, "d", &x)){
+    return NULL;
+  }
+  self->ops->set_x(self->data, x);
+  Py_RETURN_NONE;
+}
+
+static PyObject *Solver_set_step(SolverObject *self, PyObject *args){
+  double h;
+  SOLVER_READY(self);
+  if(!PyArg_ParseTuple(args, "d", &h)){
+    return NULL;
+  }
+  self->ops->set_step(self->data, h);
+  self->h = h;
+  Py_RETURN_NONE;
+}
+
+static PyObject *Solver_step_n(SolverObject *self, PyObject *args){
+  unsigned n = 1;
+  SOLVER_READY(self);
+  if(!PyArg_ParseTuple(args, "|I", &n)){
+    return NULL;
+  }
+  if(!self->rhs && !self->cfunc){
+    PyErr_SetString(PyExc_RuntimeError, "right side not set");
+    return NULL;
+  }
+  if(!self->ops->check(self->data)){
+    PyErr_SetString(PyExc_RuntimeError, "solver check failed");
+    return NULL;
+  }
+  self->failed = 0;
+  if(self->cfunc){
+    Py_BEGIN_ALLOW_THREADS
+    self->ops->step_n(self->data, n);
+    Py_END_ALLOW_THREADS
+  } else {
+    /* the step the right side raised in is undone; setting the step
+     * again restarts the start-up steps of the multistep methods */
+    size_t size = sizeof(double)*self->eq_num;
+    double *saved = PyMem_Malloc(2*size);
+    double x = 0.;
+    if(!saved){
+      return PyErr_NoMemory();
+    }
+    Py_BEGIN_ALLOW_THREADS
+    for(unsigned i = 0; i < n && !self->failed; i++){
+      memcpy(saved, self->ops->get_ys(self->data), size);
+      memcpy(saved + self->eq_num, self->ops->get_dys(self->data), size);
+      x = self->ops->get_x(self->data);
+      self->ops->step(self->data);
+    }
+    if(self->failed){
+      memcpy(self->ops->get_ys(self->data), saved, size);
+      memcpy(self->ops->get_dys(self->data), saved + self->eq_num, size);
+      self->ops->set_x(self->data, x);
+      self->ops->set_step(self->data, self->h);
+    }
+    Py_END_ALLOW_THREADS
+    PyMem_Free(saved);
+  }
+  if(self->failed){
+    return NULL;
+  }
+  Py_RETURN_NONE;
+}
+
+static PyObject *Solver_get_y(SolverObject *self, void *closure){
+  SOLVER_READY(self);
+  return SolverView(self, self->ops->get_ys(self->data));
+}
+
+static PyObject *Solver_get_dy(SolverObject *self, void *closure){
+  SOLVER_READY(self);
+  return SolverView(self, self->ops->get_dys(self->data));
+}
+
+static PyObject *Solver_get_x(SolverObject *self, void *closure){
+  SOLVER_READY(self);
+  return PyFloat_FromDouble(self->ops->get_x(self->data));
+}
+
+static PyMethodDef Solver_methods[] = {
+  {"set_rhs", (PyCFunction)Solver_set_rhs, METH_VARARGS,
+   "set_rhs(f[, userdata]): f(x, y, dy) callable or C function address."},
+  {"set_x", (PyCFunction)Solver_set_x, METH_VARARGS, "Set x."},
+  {"set_step", (PyCFunction)Solver_set_step, METH_VARARGS, "Set step h."},
+  {"step_n", (PyCFunction)Solver_step_n, METH_VARARGS,
+   "step_n([n]): take n steps with the GIL released. If the right side\n"
+   "raises, y, dy and x keep their values from before the failed step\n"
+   "and step_n can be called again."},
+  {NULL}
+};
+
+static PyGetSetDef Solver_getset[] = {
+  {"y", (getter)Solver_get_y, NULL, "State, a view of the solver buffer.",
+   NULL},
+  {"dy", (getter)Solver_get_dy, NULL, "Slope of the last step.", NULL},
+  {"x", (getter)Solver_get_x, NULL, "Current x.", NULL},
+  {NULL}
+};
+
+static PyTypeObject SolverType = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+  .tp_name = "emethods.Solver",
+  .tp_doc = "Solver(method, eq_num) with method rk4, rk5, adams or adams5.",
+  .tp_basicsize = sizeof(SolverObject),
+  .tp_flags = Py_TPFLAGS_DEFAULT,
+  .tp_new = PyType_GenericNew,
+  .tp_init = (initproc)Solver_init,
+  .tp_dealloc = (destructor)Solver_dealloc,
+  .tp_methods = Solver_methods,
+  .tp_getset = Solver_getset,
+};
+
+static struct PyModuleDef emethods_module = {
+  PyModuleDef_HEAD_INIT, "emethods", "Explicit ODE solvers.", -1, NULL
+};
+
+PyMODINIT_FUNC PyInit_emethods(void){
+  PyObject *m;
+  import_array();
+  if(PyType_Ready(&SolverType) < 0){
+    return NULL;
+  }
+  m = PyModule_Create(&emethods_module);
+  if(!m){
+    return NULL;
+  }
+  Py_INCREF(&SolverType);
+  if(PyModule_AddObject(m, "Solver", (PyObject *)&SolverType) < 0){
+    Py_DECREF(&SolverType);
+    Py_DECREF(m);
+    return NULL;
+  }
+  return m;
+}
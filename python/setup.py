@@ -0,0 +1,21 @@
+# Build in place with: python3 setup.py build_ext --inplace
+import os
+import numpy
+from setuptools import setup, Extension
+
+ROOT = os.path.relpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+SRC = ["rk4.c", "rk5.c", "adams.c", "adams5.c", "pool.c"]
+
+setup(
+    name="emethods",
+    ext_modules=[
+        Extension(
+            "emethods",
+            sources=[os.path.join(os.path.dirname(__file__) or ".", "emethods.c")] +
+                    [os.path.join(ROOT, "src", f) for f in SRC],
+            include_dirs=[os.path.join(ROOT, "include"), numpy.get_include()],
+            extra_compile_args=["-std=c99", "-O2"],
+            extra_link_args=["-pthread"],
+        )
+    ],
+)
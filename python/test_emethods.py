@@ -0,0 +1,100 @@
+# Smoke test of the binding: builds it into a temporary directory and
+# steps every method. Run with: python3 test_emethods.py
+import ctypes
+import math
+import os
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SKIP = 77
+
+
+def build(out):
+    subprocess.check_call(
+        [sys.executable, "setup.py", "-q", "build_ext",
+         "--build-lib", out, "--build-temp", os.path.join(out, "tmp")],
+        cwd=HERE)
+    sys.path.insert(0, out)
+
+
+def oscillator(x, y, dy):
+    dy[0] = y[1]
+    dy[1] = -y[0]
+
+
+C_SYSTEM = ctypes.CFUNCTYPE(None, ctypes.c_double,
+                            ctypes.POINTER(ctypes.c_double),
+                            ctypes.POINTER(ctypes.c_double), ctypes.c_void_p)
+
+
+@C_SYSTEM
+def c_oscillator(x, y, dy, userdata):
+    w = ctypes.cast(userdata, ctypes.POINTER(ctypes.c_double))[0]
+    dy[0] = w*y[1]
+    dy[1] = -w*y[0]
+
+
+def failing(x, y, dy):
+    raise ZeroDivisionError
+
+
+def main():
+    try:
+        import numpy  # noqa: F401
+        import setuptools  # noqa: F401
+    except ImportError:
+        return SKIP
+    with tempfile.TemporaryDirectory() as out:
+        build(out)
+        import emethods
+        for method in ("rk4", "rk5", "adams", "adams5"):
+            s = emethods.Solver(method, 2)
+            s.y[:] = [1., 0.]
+            s.set_x(0.)
+            s.set_step(1.E-3)
+            s.set_rhs(oscillator)
+            s.step_n(1000)
+            assert abs(s.x - 1.) < 1.E-12, method
+            assert abs(s.y[0] - math.cos(1.)) < 1.E-9, method
+            # a raising right side must leave the state as it was
+            y, x = s.y.copy(), s.x
+            s.set_rhs(failing)
+            try:
+                s.step_n(10)
+            except ZeroDivisionError:
+                pass
+            else:
+                raise AssertionError(method)
+            assert s.x == x and (s.y == y).all(), method
+            s.set_rhs(oscillator)
+            s.step_n(1000)
+            assert abs(s.y[0] - math.cos(2.)) < 1.E-8, method
+            # arrays kept by the right side must stay valid copies
+            kept = []
+
+            def keeping(x, y, dy):
+                oscillator(x, y, dy)
+                kept.append((y, y.copy(), dy, dy.copy()))
+            s.set_rhs(keeping)
+            s.step_n(10)
+            for y, y_then, dy, dy_then in kept:
+                assert (y == y_then).all() and (dy == dy_then).all(), method
+            # compiled right side by address, with userdata
+            w = ctypes.c_double(2.)
+            c = emethods.Solver(method, 2)
+            c.y[:] = [1., 0.]
+            c.set_x(0.)
+            c.set_step(1.E-3)
+            c.set_rhs(ctypes.cast(c_oscillator, ctypes.c_void_p).value,
+                      ctypes.addressof(w))
+            c.step_n(1000)
+            assert abs(c.x - 1.) < 1.E-12, method
+            assert abs(c.y[0] - math.cos(2.)) < 1.E-9, method
+    print("emethods: ok")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
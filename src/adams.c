@@ -12,6 +12,7 @@ struct adams_data_st{
   int boost_step;
   double h;
   AdamsRSFunc *funcs;
+  AdamsSysFunc sys;
   double *f;
   void *userdata;
 };
@@ -48,6 +49,7 @@ error:
 void AdamsFreeData(a_data *data){
   if(data){
     free(data->f);
+    free(data->dy);
     free(data->funcs);
     free(data->y);
     free(data);
@@ -110,6 +112,14 @@ int AdamsSetEquations(a_data *data, AdamsRSFunc func[],
   return 1;
 }
 
+int AdamsSetSystem(a_data *data, AdamsSysFunc func){
+  if(!data){
+    return 0;
+  }
+  data->sys = func;
+  return 1;
+}
+
 int AdamsCheck(a_data *data){
   if(!data || !data->eq_num){
     fprintf(stderr, "%s\n", "AdamsCheck: Incorrect initialization.");
@@ -119,6 +129,9 @@ int AdamsCheck(a_data *data){
     fprintf(stderr, "%s\n", "AdamsCheck: Step must be greater then 0.");
     return 0;
   }
+  if(data->sys){
+    return 1;
+  }
   for(unsigned i = 0; i< data->eq_num; i++){
     if(!data->funcs[i]){
       fprintf(stderr, "%s%d%s\n", "AdamsCheck: Right side functions for parameter number ", i, " not assigned.");
@@ -128,6 +141,17 @@ int AdamsCheck(a_data *data){
   return 1;
 }
 
+static void AdamsEval(a_data *data, double const x, double const *y,
+                     double *k){
+  if(data->sys){
+    data->sys(x, y, k, data->userdata);
+    return;
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    k[i] = data->funcs[i](x, y, data->userdata);
+  }
+}
+
 static void BoostRK4Step(a_data *data){
   double k1[data->eq_num], k2[data->eq_num], k3[data->eq_num], k4[data->eq_num];
   double y[data->eq_num];
@@ -135,22 +159,22 @@ static void BoostRK4Step(a_data *data){
   double h05 = data->h * 0.5;
   double t = data->x + h05;
   (data->boost_step)--;
+  AdamsEval(data, data->x, data->y, k1);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k1[i] = data->funcs[i](data->x, data->y, data->userdata);
     data->f[i*(BOOST_STEPS+1) + data->boost_step] = k1[i];
     y[i] = data->y[i] + h05*k1[i];
   }
+  AdamsEval(data, t, y, k2);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k2[i] = data->funcs[i](t, y, data->userdata);
     yn[i] = data->y[i] + h05*k2[i];
   }
+  AdamsEval(data, t, yn, k3);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k3[i] = data->funcs[i](t, yn, data->userdata);
     y[i] = data->y[i] + data->h*k3[i];
   }
   data->x += data->h;
+  AdamsEval(data, data->x, y, k4);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k4[i] = data->funcs[i](data->x, y, data->userdata);
     data->dy[i] = 1./6*(k1[i] + 2.*k2[i] + 2.*k3[i] + k4[i]);
     data->y[i] += data->h*data->dy[i];
   }
@@ -158,10 +182,12 @@ static void BoostRK4Step(a_data *data){
 
 static void MainAdamsStep(a_data *data){
   double y[data->eq_num];
+  double k[data->eq_num];
+  AdamsEval(data, data->x, data->y, k);
   for(unsigned i = 0; i<data->eq_num; i++){
     unsigned j = i*(BOOST_STEPS + 1);
     memmove(&(data->f[j + 1]), &(data->f[j]), sizeof(double)*BOOST_STEPS);
-    data->f[j] = data->funcs[i](data->x, data->y, data->userdata);
+    data->f[j] = k[i];
     data->dy[i] = kf[0]*data->f[j] +
                   kf[1]*data->f[j + 1] +
                   kf[2]*data->f[j + 2] +
@@ -180,6 +206,12 @@ void AdamsStep(a_data *data){
   }
 }
 
+void AdamsStepN(a_data *data, unsigned const n){
+  for(unsigned i = 0; i < n; i++){
+    AdamsStep(data);
+  }
+}
+
 double AdamsGetY(a_data *data, unsigned const num){
   if(!data || num >= data->eq_num){
     return 0.;
@@ -208,6 +240,13 @@ double AdamsGetDY(a_data *data, unsigned const num){
   return data->dy[num];
 }
 
+double *AdamsGetDYs(a_data *data){
+  if(data){
+    return data->dy;
+  }
+  return NULL;
+}
+
 int AdamsSetUserData(a_data *data, void *userdata){
   if(data){
     data->userdata = userdata;
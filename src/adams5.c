@@ -12,6 +12,7 @@ struct adams5_data_st{
   int boost_step;
   double h;
   Adams5RSFunc *funcs;
+  Adams5SysFunc sys;
   double *f;
   void *userdata;
 };
@@ -113,6 +114,14 @@ int Adams5SetEquations(a5_data *data, Adams5RSFunc func[],
   return 1;
 }
 
+int Adams5SetSystem(a5_data *data, Adams5SysFunc func){
+  if(!data){
+    return 0;
+  }
+  data->sys = func;
+  return 1;
+}
+
 int Adams5Check(a5_data *data){
   if(!data || !data->eq_num){
     fprintf(stderr, "%s\n", "Adams5Check: Incorrect initialization.");
@@ -122,6 +131,9 @@ int Adams5Check(a5_data *data){
     fprintf(stderr, "%s\n", "Adams5Check: Step must be greater then 0.");
     return 0;
   }
+  if(data->sys){
+    return 1;
+  }
   for(unsigned i = 0; i< data->eq_num; i++){
     if(!data->funcs[i]){
       fprintf(stderr, "%s%d%s\n", "Adams5Check: Right side functions for parameter number ", i, " not assigned.");
@@ -133,45 +145,48 @@ int Adams5Check(a5_data *data){
 
 static const double RK5_CONST[] = {1./24., 5./48., 27./56., 125./336.};
 
+static void Adams5Eval(a5_data *data, double const x, double const *y,
+                      double *k){
+  if(data->sys){
+    data->sys(x, y, k, data->userdata);
+    return;
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    k[i] = data->funcs[i](x, y, data->userdata);
+  }
+}
+
 static void BoostRK5Step(a5_data *data){
   double k1[data->eq_num], k2[data->eq_num], k3[data->eq_num],
          k4[data->eq_num], k5[data->eq_num], k6[data->eq_num];
   double y[data->eq_num];
   double yn[data->eq_num];
   (data->boost_step)--;
+  Adams5Eval(data, data->x, data->y, k1);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k1[i] = data->funcs[i](data->x, data->y, data->userdata);
     data->f[i*(BOOST_STEPS + 1) + data->boost_step] = k1[i];
     y[i] = data->y[i] + 0.5*data->h*k1[i];
   }
+  Adams5Eval(data, data->x + 0.5*data->h, y, k2);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k2[i] = data->funcs[i](data->x + 0.5*data->h,
-                           y,
-                           data->userdata);
     yn[i] = data->y[i] + 0.25*data->h*(k1[i] + k2[i]);
   }
+  Adams5Eval(data, data->x + 0.5*data->h, yn, k3);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k3[i] = data->funcs[i](data->x + 0.5*data->h,
-                           yn,
-                           data->userdata);
     y[i] = data->y[i] + data->h*(2.*k3[i] - k2[i]);
   }
+  Adams5Eval(data, data->x + data->h, y, k4);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k4[i] = data->funcs[i](data->x + data->h,
-                           y,
-                           data->userdata);
     yn[i] = data->y[i] + 1./27.*data->h*(7.*k1[i] + 10.*k2[i]+k4[i]);
   }
+  Adams5Eval(data, data->x + 2./3.*data->h, yn, k5);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k5[i] = data->funcs[i](data->x + 2./3.*data->h,
-                           yn,
-                           data->userdata);
     y[i] = data->y[i] + 1./625.*data->h*(28.*k1[i] - 125.*k2[i] +
                                          546.*k3[i] + 54.*k4[i] -
                                          378.*k5[i]);
   }
+  Adams5Eval(data, data->x + 1./5.*data->h, y, k6);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k6[i] = data->funcs[i](data->x + 1./5.*data->h, y, data->userdata);
     data->dy[i] = RK5_CONST[0]*k1[i] + RK5_CONST[1]*k4[i] +
                   RK5_CONST[2]*k5[i] + RK5_CONST[3]*k6[i];
     data->y[i] += data->h*data->dy[i];
@@ -181,10 +196,12 @@ static void BoostRK5Step(a5_data *data){
 
 static void MainAdams5Step(a5_data *data){
   double y[data->eq_num];
+  double k[data->eq_num];
+  Adams5Eval(data, data->x, data->y, k);
   for(unsigned i = 0; i<data->eq_num; i++){
     unsigned j = i*(BOOST_STEPS + 1);
     memmove(&(data->f[j+1]), &(data->f[j]), sizeof(double)*BOOST_STEPS);
-    data->f[j] = data->funcs[i](data->x, data->y, data->userdata);
+    data->f[j] = k[i];
     data->dy[i] = kf[0]*data->f[j] +
                   kf[1]*data->f[j + 1] +
                   kf[2]*data->f[j + 2] +
@@ -204,6 +221,12 @@ void Adams5Step(a5_data *data){
   }
 }
 
+void Adams5StepN(a5_data *data, unsigned const n){
+  for(unsigned i = 0; i < n; i++){
+    Adams5Step(data);
+  }
+}
+
 double Adams5GetY(a5_data *data, unsigned const num){
   if(!data || num >= data->eq_num){
     return 0.;
@@ -232,6 +255,13 @@ double Adams5GetDY(a5_data *data, unsigned const num){
   return data->dy[num];
 }
 
+double *Adams5GetDYs(a5_data *data){
+  if(data){
+    return data->dy;
+  }
+  return NULL;
+}
+
 int Adams5SetUserData(a5_data *data, void *userdata){
   if(data){
     data->userdata = userdata;
@@ -0,0 +1,311 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "stdint.h"
+#include "time.h"
+#include "autotune.h"
+
+struct autotune_data_st{
+  runner_data *runner;
+  double fraction;
+  char *cache;
+  int cached;
+  int valid[RUNNER_SOLVERS];
+  autotune_result candidates[RUNNER_SOLVERS];
+};
+
+/* Counts right side calls of a probe. */
+struct autotune_probe_st{
+  RunnerSysFunc func;
+  void *userdata;
+  unsigned long evals;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+#define AUTOTUNE_ITERATIONS 12
+#define AUTOTUNE_MIN_STEPS 8
+#define AUTOTUNE_MAX_STEPS 10000000.
+#define AUTOTUNE_SAFETY 0.8
+#define AUTOTUNE_MIN_TIME 2.E-3
+#define AUTOTUNE_MAX_REPEATS 64
+
+static unsigned const autotune_order[RUNNER_SOLVERS] = {4, 5, 4, 5};
+
+int AutotuneInitData(autotune_data **data){
+  *data = calloc(1, sizeof(autotune_data));
+  EXIT_IF_NULL(*data);
+  (*data)->fraction = 0.1;
+  /* one thread: probes are timed and must not compete with each other */
+  if(!RunnerInitData(&(*data)->runner, 1)){
+    goto error;
+  }
+  return 1;
+error:
+  if(*data){
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void AutotuneFreeData(autotune_data *data){
+  if(data){
+    RunnerFreeData(data->runner);
+    free(data->cache);
+    free(data);
+  }
+}
+
+int AutotuneSetProbeSpan(autotune_data *data, double const fraction){
+  if(!data || !(fraction > 0.) || fraction > 1.){
+    return 0;
+  }
+  data->fraction = fraction;
+  return 1;
+}
+
+int AutotuneSetCache(autotune_data *data, char const *path){
+  if(!data){
+    return 0;
+  }
+  char *cache = NULL;
+  if(path){
+    cache = malloc(strlen(path) + 1);
+    if(!cache){
+      return 0;
+    }
+    strcpy(cache, path);
+  }
+  free(data->cache);
+  data->cache = cache;
+  return 1;
+}
+
+/* Bitwise, since -ffast-math lets the compiler assume isfinite(). */
+static int AutotuneFinite(double const v){
+  uint64_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  return (bits >> 52 & 0x7FF) != 0x7FF;
+}
+
+static double AutotuneClock(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1.E-9*ts.tv_nsec;
+}
+
+static void AutotuneCount(double const x, double const *y, double *dy,
+                          void *userdata){
+  struct autotune_probe_st *probe = userdata;
+  probe->evals++;
+  probe->func(x, y, dy, probe->userdata);
+}
+
+static uint64_t AutotuneHash(uint64_t hash, void const *bytes,
+                             size_t const size){
+  unsigned char const *b = bytes;
+  for(size_t i = 0; i < size; i++){
+    hash = (hash ^ b[i])*0x100000001B3ULL;
+  }
+  return hash;
+}
+
+/* FNV-1a of everything that identifies the problem but the right side
+ * itself, whose address changes between runs. */
+static uint64_t AutotuneKey(runner_job const *problem, char const *name,
+                            double const tol){
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  if(name){
+    hash = AutotuneHash(hash, name, strlen(name));
+  }
+  hash = AutotuneHash(hash, &problem->eq_num, sizeof(problem->eq_num));
+  hash = AutotuneHash(hash, &problem->x0, sizeof(double));
+  hash = AutotuneHash(hash, &problem->x_end, sizeof(double));
+  hash = AutotuneHash(hash, &tol, sizeof(double));
+  return AutotuneHash(hash, problem->y0, sizeof(double)*problem->eq_num);
+}
+
+static int AutotuneLookup(autotune_data *data, uint64_t const key,
+                          autotune_result *result){
+  FILE *file = fopen(data->cache, "r");
+  unsigned long long k;
+  int solver, found = 0;
+  autotune_result r;
+  if(!file){
+    return 0;
+  }
+  while(!found && fscanf(file, "%llx %d %lg %lg %lg %lu", &k, &solver,
+                         &r.h, &r.error, &r.seconds, &r.evals) == 6){
+    if(k == key && solver >= 0 && solver < RUNNER_SOLVERS){
+      r.solver = (enum RunnerSolver)solver;
+      *result = r;
+      found = 1;
+    }
+  }
+  fclose(file);
+  return found;
+}
+
+static void AutotuneStore(autotune_data *data, uint64_t const key,
+                          autotune_result const *r){
+  FILE *file = fopen(data->cache, "a");
+  if(file){
+    fprintf(file, "%016llx %d %.17g %.17g %.17g %lu\n",
+            (unsigned long long)key, (int)r->solver, r->h, r->error,
+            r->seconds, r->evals);
+    fclose(file);
+  }
+}
+
+/* Integrates the probe span with h into y; the evaluations go to
+ * probe->evals. */
+static int AutotuneProbe(autotune_data *data, runner_job const *problem,
+                         enum RunnerSolver const solver, double const span,
+                         double const h, struct autotune_probe_st *probe,
+                         double *y){
+  runner_job job = {.solver = solver, .eq_num = problem->eq_num,
+                    .y0 = problem->y0, .x0 = problem->x0,
+                    .x_end = problem->x0 + span, .h = h,
+                    .func = AutotuneCount, .userdata = probe, .y = y};
+  if(!RunnerRun(data->runner, &job, 1)){
+    return 0;
+  }
+  for(unsigned i = 0; i < problem->eq_num; i++){
+    if(!AutotuneFinite(y[i])){
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static double AutotuneNorm(double const *a, double const *b,
+                           unsigned const num){
+  double norm = 0.;
+  for(unsigned i = 0; i < num; i++){
+    double scale = fabs(b[i]) > 1. ? fabs(b[i]) : 1.;
+    norm = fmax(norm, fabs(a[i] - b[i]) / scale);
+  }
+  return norm;
+}
+
+/* Largest probed step whose scaled error estimate meets tol. The step
+ * is capped so the probe keeps AUTOTUNE_MIN_STEPS steps, enough for the
+ * Adams methods to leave their start-up. */
+static int AutotuneSolver(autotune_data *data, runner_job const *problem,
+                          enum RunnerSolver const solver, double const tol,
+                          autotune_result *result){
+  unsigned n = problem->eq_num;
+  unsigned p = autotune_order[solver];
+  double span = data->fraction*(problem->x_end - problem->x0);
+  double scale = 1. / data->fraction;
+  double h_max = span / AUTOTUNE_MIN_STEPS;
+  double h_min = span / AUTOTUNE_MAX_STEPS;
+  double h = h_max / 4.;
+  double richardson = pow(2., p) / (pow(2., p) - 1.);
+  double y1[n], y2[n];
+  struct autotune_probe_st probe = {.func = problem->func,
+                                    .userdata = problem->userdata};
+  int accepted = 0;
+  for(unsigned it = 0; it < AUTOTUNE_ITERATIONS; it++){
+    if(!AutotuneProbe(data, problem, solver, span, h, &probe, y1) ||
+       !AutotuneProbe(data, problem, solver, span, 0.5*h, &probe, y2)){
+      /* unstable at this step: retry smaller */
+      accepted = 0;
+      h *= 0.25;
+      if(h < h_min){
+        return 0;
+      }
+      continue;
+    }
+    double error = richardson*AutotuneNorm(y1, y2, n)*scale;
+    double h_new = error > 0. ?
+                   h*AUTOTUNE_SAFETY*pow(tol / error, 1. / p) : h_max;
+    h_new = fmin(fmin(h_new, 4.*h), h_max);
+    if(error <= tol){
+      result->h = h;
+      result->error = error;
+      accepted = 1;
+      if(h_new <= 1.2*h){
+        break;
+      }
+    } else if(accepted){
+      /* the larger step failed: keep the last one that met tol */
+      break;
+    } else {
+      h_new = fmin(h_new, 0.5*h);
+    }
+    if(h_new < h_min){
+      return 0;
+    }
+    h = h_new;
+  }
+  if(!accepted){
+    return 0;
+  }
+  /* timed on its own, repeated until the clock resolves it */
+  unsigned repeats = 0;
+  double start = AutotuneClock(), seconds;
+  probe.evals = 0;
+  do{
+    if(!AutotuneProbe(data, problem, solver, span, result->h, &probe, y1)){
+      return 0;
+    }
+    seconds = AutotuneClock() - start;
+  }while(++repeats < AUTOTUNE_MAX_REPEATS && seconds < AUTOTUNE_MIN_TIME);
+  result->solver = solver;
+  result->seconds = seconds / repeats*scale;
+  result->evals = (unsigned long)((double)probe.evals / repeats*scale + 0.5);
+  return 1;
+}
+
+int AutotuneRun(autotune_data *data, runner_job const *problem,
+                char const *name, double const tol, autotune_result *result){
+  if(!data || !problem || !result || !problem->func || !problem->y0 ||
+     !problem->eq_num || !(problem->x_end > problem->x0) || !(tol > 0.)){
+    return 0;
+  }
+  uint64_t key = AutotuneKey(problem, name, tol);
+  data->cached = 0;
+  memset(data->valid, 0, sizeof(data->valid));
+  if(data->cache && AutotuneLookup(data, key, result)){
+    data->cached = 1;
+    return 1;
+  }
+  int best = -1;
+  for(unsigned s = 0; s < RUNNER_SOLVERS; s++){
+    autotune_result *c = data->candidates + s;
+    data->valid[s] = AutotuneSolver(data, problem, (enum RunnerSolver)s,
+                                    tol, c);
+    if(data->valid[s] && (best < 0 ||
+       c->seconds < data->candidates[best].seconds)){
+      best = s;
+    }
+  }
+  if(best < 0){
+    return 0;
+  }
+  *result = data->candidates[best];
+  if(data->cache){
+    AutotuneStore(data, key, result);
+  }
+  return 1;
+}
+
+int AutotuneGetCandidate(autotune_data *data, enum RunnerSolver const solver,
+                         autotune_result *result){
+  if(!data || !result || solver >= RUNNER_SOLVERS || !data->valid[solver]){
+    return 0;
+  }
+  *result = data->candidates[solver];
+  return 1;
+}
+
+int AutotuneGetCached(autotune_data *data){
+  if(data){
+    return data->cached;
+  }
+  return 0;
+}
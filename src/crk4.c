@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include "stdlib.h"
+#include "crk4.h"
+
+/* A double complex is laid out as double[2] (C99 6.2.5), so the stage
+ * combinations, whose coefficients are all real, run over the state as
+ * 2 * eq_num interleaved doubles: one plain loop the compiler vectorizes
+ * for both parts at once. */
+
+struct crk4_data_st{
+  unsigned eq_num;
+  double complex *y;
+  double complex *f;
+  double x;
+  double h;
+  CRK4RSFunc *funcs;
+  CRK4SysFunc sys;
+  void *userdata;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+int CRK4InitData(crk4_data **data, unsigned const eq_num){
+  *data = calloc(1, sizeof(crk4_data));
+  EXIT_IF_NULL(*data);
+  (*data)->eq_num = eq_num;
+  (*data)->y = calloc(eq_num, sizeof(double complex));
+  EXIT_IF_NULL((*data)->y);
+  (*data)->funcs = calloc(eq_num, sizeof(CRK4RSFunc));
+  EXIT_IF_NULL((*data)->funcs);
+  (*data)->f = calloc(eq_num, sizeof(double complex));
+  EXIT_IF_NULL((*data)->f);
+  return 1;
+error:
+  if(*data){
+    free((*data)->funcs);
+    free((*data)->y);
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void CRK4FreeData(crk4_data *data){
+  if(data){
+    free(data->f);
+    free(data->funcs);
+    free(data->y);
+    free(data);
+  }
+}
+
+int CRK4SetYs0(crk4_data *data, double complex const ys[],
+               unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->y[i] = ys[i];
+  }
+  return 1;
+}
+
+int CRK4SetY0(crk4_data *data, double complex const y, unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0;
+  }
+  data->y[index] = y;
+  return 1;
+}
+
+int CRK4SetX(crk4_data *data, double const t){
+  if(!data){
+    return 0;
+  }
+  data->x = t;
+  return 1;
+}
+
+int CRK4SetStep(crk4_data *data, double const step){
+  if(!data){
+    return 0;
+  }
+  data->h = step;
+  return 1;
+}
+
+int CRK4SetEquation(crk4_data *data, CRK4RSFunc func,
+                    unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0;
+  }
+  data->funcs[index] = func;
+  return 1;
+}
+
+int CRK4SetEquations(crk4_data *data, CRK4RSFunc func[],
+                     unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->funcs[i] = func[i];
+  }
+  return 1;
+}
+
+int CRK4SetSystem(crk4_data *data, CRK4SysFunc func){
+  if(!data){
+    return 0;
+  }
+  data->sys = func;
+  return 1;
+}
+
+int CRK4Check(crk4_data *data){
+  if(!data || !data->eq_num){
+    fprintf(stderr, "%s\n", "CRK4Check: Incorrect initialization.");
+    return 0;
+  }
+  if(0. == data->h){
+    fprintf(stderr, "%s\n", "CRK4Check: Step must be greater then 0.");
+    return 0;
+  }
+  if(data->sys){
+    return 1;
+  }
+  for(unsigned i = 0; i< data->eq_num; i++){
+    if(!data->funcs[i]){
+      fprintf(stderr, "%s%d%s\n", "CRK4Check: Right side functions for parameter number ", i, " not assigned.");
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void CRK4Eval(crk4_data *data, double const x,
+                     double complex const *y, double complex *k){
+  if(data->sys){
+    data->sys(x, y, k, data->userdata);
+    return;
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    k[i] = data->funcs[i](x, y, data->userdata);
+  }
+}
+
+void CRK4Step(crk4_data *data){
+  unsigned n = data->eq_num, n2 = 2*data->eq_num;
+  double complex k1[n], k2[n], k3[n], k4[n], y[n], yn[n];
+  double const *r1 = (double *)k1, *r2 = (double *)k2, *r3 = (double *)k3;
+  double const *r4 = (double *)k4, *ry0 = (double *)data->y;
+  double *ry = (double *)y, *ryn = (double *)yn;
+  double *rf = (double *)data->f, *rys = (double *)data->y;
+  double h05 = data->h * 0.5;
+  double t = data->x + h05;
+  CRK4Eval(data, data->x, data->y, k1);
+  for(unsigned i = 0; i < n2; i++){
+    ry[i] = ry0[i] + h05*r1[i];
+  }
+  CRK4Eval(data, t, y, k2);
+  for(unsigned i = 0; i < n2; i++){
+    ryn[i] = ry0[i] + h05*r2[i];
+  }
+  CRK4Eval(data, t, yn, k3);
+  for(unsigned i = 0; i < n2; i++){
+    ry[i] = ry0[i] + data->h*r3[i];
+  }
+  data->x += data->h;
+  CRK4Eval(data, data->x, y, k4);
+  for(unsigned i = 0; i < n2; i++){
+    rf[i] = 1./6*(r1[i] + 2*r2[i] + 2*r3[i] + r4[i]);
+    rys[i] += data->h * rf[i];
+  }
+}
+
+void CRK4StepN(crk4_data *data, unsigned const n){
+  for(unsigned i = 0; i < n; i++){
+    CRK4Step(data);
+  }
+}
+
+double complex CRK4GetY(crk4_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->y[num];
+}
+
+double complex *CRK4GetYs(crk4_data *data){
+  if(data){
+    return data->y;
+  }
+  return NULL;
+}
+
+double CRK4GetX(crk4_data *data){
+  if(data){
+    return data->x;
+  }
+  return 0.;
+}
+
+double complex CRK4GetDY(crk4_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->f[num];
+}
+
+double complex *CRK4GetDYs(crk4_data *data){
+  if(data){
+    return data->f;
+  }
+  return NULL;
+}
+
+int CRK4SetUserData(crk4_data *data, void *userdata){
+  if(data){
+    data->userdata = userdata;
+    return 1;
+  }
+  return 0;
+}
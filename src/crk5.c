@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include "stdlib.h"
+#include "crk5.h"
+
+/* Same tableau as RK5; the stage combinations run over the interleaved
+ * real and imaginary parts as in crk4.c. */
+
+struct crk5_data_st{
+  unsigned eq_num;
+  double complex *y;
+  double complex *f;
+  double x;
+  double h;
+  CRK5RSFunc *funcs;
+  CRK5SysFunc sys;
+  void *userdata;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+int CRK5InitData(crk5_data **data, unsigned const eq_num){
+  *data = calloc(1, sizeof(crk5_data));
+  EXIT_IF_NULL(*data);
+  (*data)->eq_num = eq_num;
+  (*data)->y = calloc(eq_num, sizeof(double complex));
+  EXIT_IF_NULL((*data)->y);
+  (*data)->funcs = calloc(eq_num, sizeof(CRK5RSFunc));
+  EXIT_IF_NULL((*data)->funcs);
+  (*data)->f = calloc(eq_num, sizeof(double complex));
+  EXIT_IF_NULL((*data)->f);
+  return 1;
+error:
+  if(*data){
+    free((*data)->funcs);
+    free((*data)->y);
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void CRK5FreeData(crk5_data *data){
+  if(data){
+    free(data->f);
+    free(data->funcs);
+    free(data->y);
+    free(data);
+  }
+}
+
+int CRK5SetYs0(crk5_data *data, double complex const ys[],
+               unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->y[i] = ys[i];
+  }
+  return 1;
+}
+
+int CRK5SetY0(crk5_data *data, double complex const y, unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0;
+  }
+  data->y[index] = y;
+  return 1;
+}
+
+int CRK5SetX(crk5_data *data, double const t){
+  if(!data){
+    return 0;
+  }
+  data->x = t;
+  return 1;
+}
+
+int CRK5SetStep(crk5_data *data, double const step){
+  if(!data){
+    return 0;
+  }
+  data->h = step;
+  return 1;
+}
+
+int CRK5SetEquation(crk5_data *data, CRK5RSFunc func,
+                    unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0;
+  }
+  data->funcs[index] = func;
+  return 1;
+}
+
+int CRK5SetEquations(crk5_data *data, CRK5RSFunc func[],
+                     unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->funcs[i] = func[i];
+  }
+  return 1;
+}
+
+int CRK5SetSystem(crk5_data *data, CRK5SysFunc func){
+  if(!data){
+    return 0;
+  }
+  data->sys = func;
+  return 1;
+}
+
+int CRK5Check(crk5_data *data){
+  if(!data || !data->eq_num){
+    fprintf(stderr, "%s\n", "CRK5Check: Incorrect initialization.");
+    return 0;
+  }
+  if(0. == data->h){
+    fprintf(stderr, "%s\n", "CRK5Check: Step must be greater then 0.");
+    return 0;
+  }
+  if(data->sys){
+    return 1;
+  }
+  for(unsigned i = 0; i< data->eq_num; i++){
+    if(!data->funcs[i]){
+      fprintf(stderr, "%s%d%s\n", "CRK5Check: Right side functions for parameter number ", i, " not assigned.");
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void CRK5Eval(crk5_data *data, double const x,
+                     double complex const *y, double complex *k){
+  if(data->sys){
+    data->sys(x, y, k, data->userdata);
+    return;
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    k[i] = data->funcs[i](x, y, data->userdata);
+  }
+}
+
+static const double CRK5_CONST[] = {1./24., 5./48., 27./56., 125./336.};
+
+void CRK5Step(crk5_data *data){
+  unsigned n = data->eq_num, n2 = 2*data->eq_num;
+  double complex k1[n], k2[n], k3[n], k4[n], k5[n], k6[n], y[n], yn[n];
+  double const *r1 = (double *)k1, *r2 = (double *)k2, *r3 = (double *)k3;
+  double const *r4 = (double *)k4, *r5 = (double *)k5, *r6 = (double *)k6;
+  double const *ry0 = (double *)data->y;
+  double *ry = (double *)y, *ryn = (double *)yn;
+  double *rf = (double *)data->f, *rys = (double *)data->y;
+  double h = data->h;
+  CRK5Eval(data, data->x, data->y, k1);
+  for(unsigned i = 0; i < n2; i++){
+    ry[i] = ry0[i] + 0.5*h*r1[i];
+  }
+  CRK5Eval(data, data->x + 0.5*h, y, k2);
+  for(unsigned i = 0; i < n2; i++){
+    ryn[i] = ry0[i] + 0.25*h*(r1[i] + r2[i]);
+  }
+  CRK5Eval(data, data->x + 0.5*h, yn, k3);
+  for(unsigned i = 0; i < n2; i++){
+    ry[i] = ry0[i] + h*(2.*r3[i] - r2[i]);
+  }
+  CRK5Eval(data, data->x + h, y, k4);
+  for(unsigned i = 0; i < n2; i++){
+    ryn[i] = ry0[i] + 1./27.*h*(7.*r1[i] + 10.*r2[i] + r4[i]);
+  }
+  CRK5Eval(data, data->x + 2./3.*h, yn, k5);
+  for(unsigned i = 0; i < n2; i++){
+    ry[i] = ry0[i] + 1./625.*h*(28.*r1[i] - 125.*r2[i] + 546.*r3[i] +
+                                54.*r4[i] - 378.*r5[i]);
+  }
+  CRK5Eval(data, data->x + 1./5.*h, y, k6);
+  for(unsigned i = 0; i < n2; i++){
+    rf[i] = CRK5_CONST[0]*r1[i] + CRK5_CONST[1]*r4[i] +
+            CRK5_CONST[2]*r5[i] + CRK5_CONST[3]*r6[i];
+    rys[i] += h*rf[i];
+  }
+  data->x += h;
+}
+
+void CRK5StepN(crk5_data *data, unsigned const n){
+  for(unsigned i = 0; i < n; i++){
+    CRK5Step(data);
+  }
+}
+
+double complex CRK5GetY(crk5_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->y[num];
+}
+
+double complex *CRK5GetYs(crk5_data *data){
+  if(data){
+    return data->y;
+  }
+  return NULL;
+}
+
+double CRK5GetX(crk5_data *data){
+  if(data){
+    return data->x;
+  }
+  return 0.;
+}
+
+double complex CRK5GetDY(crk5_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->f[num];
+}
+
+double complex *CRK5GetDYs(crk5_data *data){
+  if(data){
+    return data->f;
+  }
+  return NULL;
+}
+
+int CRK5SetUserData(crk5_data *data, void *userdata){
+  if(data){
+    data->userdata = userdata;
+    return 1;
+  }
+  return 0;
+}
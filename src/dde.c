@@ -0,0 +1,422 @@
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "dde.h"
+#include "rk4.h"
+#include "rk5.h"
+
+/* The past solution is kept as a ring of knots (x, y, y') joined by
+ * cubic Hermite segments. The ring holds just enough knots to cover
+ * max_delay at the current step. Every constant delay, and
+ * DDEGetDelayed, keeps its own cursor on the segment of its previous
+ * lookup, so the monotone times of one delay cost O(1) amortized no
+ * matter how far apart the delays are. Times past the newest knot
+ * (delays shorter than the step) extrapolate the newest segment; times
+ * before the oldest retained knot are NaN. */
+
+struct dde_data_st{
+  unsigned eq_num;
+  unsigned delay_num;
+  double max_delay;
+  enum DDEMethod method;
+  rk_data *rk4;
+  rk5_data *rk5;
+  double *y0;
+  double *tau;
+  double *yd;
+  double x0;
+  double h;
+  unsigned cap;
+  unsigned long knots;
+  unsigned count;
+  unsigned long *cursor;
+  double *kx;
+  double *ky;
+  double *kf;
+  DDERSFunc *funcs;
+  DDEHistoryFunc history;
+  void *userdata;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+static void DDESystem(double const x, double const *Y, double *DY,
+                      void *userdata);
+
+int DDEInitData(dde_data **data, unsigned const eq_num,
+                unsigned const delay_num, double const max_delay){
+  *data = calloc(1, sizeof(dde_data));
+  EXIT_IF_NULL(*data);
+  (*data)->eq_num = eq_num;
+  (*data)->delay_num = delay_num;
+  (*data)->max_delay = max_delay;
+  (*data)->y0 = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->y0);
+  (*data)->tau = calloc(delay_num + 1, sizeof(double));
+  EXIT_IF_NULL((*data)->tau);
+  (*data)->yd = calloc(eq_num*(delay_num + 1), sizeof(double));
+  EXIT_IF_NULL((*data)->yd);
+  (*data)->cursor = calloc(delay_num + 1, sizeof(unsigned long));
+  EXIT_IF_NULL((*data)->cursor);
+  (*data)->funcs = calloc(eq_num, sizeof(DDERSFunc));
+  EXIT_IF_NULL((*data)->funcs);
+  if(!RK4InitData(&(*data)->rk4, eq_num) ||
+     !RK5InitData(&(*data)->rk5, eq_num)){
+    goto error;
+  }
+  RK4SetSystem((*data)->rk4, DDESystem);
+  RK4SetUserData((*data)->rk4, *data);
+  RK5SetSystem((*data)->rk5, DDESystem);
+  RK5SetUserData((*data)->rk5, *data);
+  (*data)->method = DDE_RK4;
+  return 1;
+error:
+  if(*data){
+    RK4FreeData((*data)->rk4);
+    free((*data)->funcs);
+    free((*data)->cursor);
+    free((*data)->yd);
+    free((*data)->tau);
+    free((*data)->y0);
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void DDEFreeData(dde_data *data){
+  if(data){
+    free(data->kf);
+    free(data->ky);
+    free(data->kx);
+    RK5FreeData(data->rk5);
+    RK4FreeData(data->rk4);
+    free(data->funcs);
+    free(data->cursor);
+    free(data->yd);
+    free(data->tau);
+    free(data->y0);
+    free(data);
+  }
+}
+
+int DDESetMethod(dde_data *data, enum DDEMethod const method){
+  if(!data || (method != DDE_RK4 && method != DDE_RK5)){
+    return 0;
+  }
+  data->method = method;
+  data->count = 0;
+  return 1;
+}
+
+int DDESetYs0(dde_data *data, double const ys[],
+              unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->y0[i] = ys[i];
+  }
+  data->count = 0;
+  return 1;
+}
+
+int DDESetY0(dde_data *data, double const y, unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0;
+  }
+  data->y0[index] = y;
+  data->count = 0;
+  return 1;
+}
+
+int DDESetX(dde_data *data, double const t){
+  if(!data){
+    return 0;
+  }
+  data->x0 = t;
+  data->count = 0;
+  return 1;
+}
+
+/* Keeps the knots of the last max_delay + 2h; the ring only grows. */
+static int DDEReserve(dde_data *data, unsigned const cap){
+  unsigned const n = data->eq_num;
+  double *kx, *ky, *kf;
+  if(cap <= data->cap){
+    return 1;
+  }
+  kx = calloc(cap, sizeof(double));
+  ky = calloc(cap*n, sizeof(double));
+  kf = calloc(cap*n, sizeof(double));
+  if(!kx || !ky || !kf){
+    free(kx);
+    free(ky);
+    free(kf);
+    return 0;
+  }
+  for(unsigned l = 0; l < data->count; l++){
+    unsigned long id = data->knots - data->count + l;
+    unsigned from = id % data->cap;
+    unsigned to = id % cap;
+    kx[to] = data->kx[from];
+    memcpy(&ky[to*n], &data->ky[from*n], sizeof(double)*n);
+    memcpy(&kf[to*n], &data->kf[from*n], sizeof(double)*n);
+  }
+  free(data->kx);
+  free(data->ky);
+  free(data->kf);
+  data->kx = kx;
+  data->ky = ky;
+  data->kf = kf;
+  data->cap = cap;
+  return 1;
+}
+
+int DDESetStep(dde_data *data, double const step){
+  if(!data || step <= 0.){
+    return 0;
+  }
+  if(!DDEReserve(data, (unsigned)ceil(data->max_delay/step) + 3)){
+    return 0;
+  }
+  data->h = step;
+  return 1;
+}
+
+int DDESetDelay(dde_data *data, double const tau, unsigned const index){
+  if(!data || index >= data->delay_num || tau < 0. ||
+     tau > data->max_delay){
+    return 0;
+  }
+  data->tau[index] = tau;
+  return 1;
+}
+
+int DDESetHistory(dde_data *data, DDEHistoryFunc func){
+  if(!data){
+    return 0;
+  }
+  data->history = func;
+  return 1;
+}
+
+int DDESetEquation(dde_data *data, DDERSFunc func,
+                   unsigned const index){
+  if(!data || index >= data->eq_num){
+      return 0;
+    }
+  data->funcs[index] = func;
+  return 1;
+}
+
+int DDESetEquations(dde_data *data, DDERSFunc func[],
+                    unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->funcs[i] = func[i];
+  }
+  return 1;
+}
+
+int DDECheck(dde_data *data){
+  if(!data || !data->eq_num){
+    fprintf(stderr, "%s\n", "DDECheck: Incorrect initialization.");
+    return 0;
+  }
+  if(data->h <= 0.){
+    fprintf(stderr, "%s\n", "DDECheck: Step must be greater then 0.");
+    return 0;
+  }
+  for(unsigned i = 0; i< data->eq_num; i++){
+    if(!data->funcs[i]){
+      fprintf(stderr, "%s%d%s\n", "DDECheck: Right side functions for parameter number ", i, " not assigned.");
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void DDEPush(dde_data *data, double const x, double const *y,
+                    double const *f){
+  unsigned const n = data->eq_num;
+  unsigned slot = data->knots % data->cap;
+  data->kx[slot] = x;
+  memcpy(&data->ky[slot*n], y, sizeof(double)*n);
+  memcpy(&data->kf[slot*n], f, sizeof(double)*n);
+  data->knots++;
+  if(data->count < data->cap){
+    data->count++;
+  }
+}
+
+/* Id of the knot starting the segment that holds t, walking from the
+ * given cursor (delay k, or delay_num for DDEGetDelayed). */
+static unsigned long DDESegment(dde_data *data, double const t,
+                                unsigned const cursor){
+  unsigned long first = data->knots - data->count;
+  unsigned long last = data->knots - 1;
+  unsigned long c = data->cursor[cursor];
+  if(c < first){
+    c = first;
+  }
+  if(c >= last){
+    c = last ? last - 1 : 0;
+    c = c < first ? first : c;
+  }
+  while(c > first && t < data->kx[c % data->cap]){
+    c--;
+  }
+  while(c + 1 < last && t > data->kx[(c + 1) % data->cap]){
+    c++;
+  }
+  data->cursor[cursor] = c;
+  return c;
+}
+
+static double DDEHermite(dde_data *data, unsigned long const id,
+                         double const t, unsigned const i){
+  unsigned const n = data->eq_num;
+  unsigned a = id % data->cap;
+  double ya = data->ky[a*n + i], fa = data->kf[a*n + i];
+  if(data->count < 2){
+    return ya + (t - data->kx[a])*fa;
+  }
+  unsigned b = (id + 1) % data->cap;
+  double yb = data->ky[b*n + i], fb = data->kf[b*n + i];
+  double hs = data->kx[b] - data->kx[a];
+  double s = (t - data->kx[a])/hs;
+  double s2 = s*s, s3 = s2*s;
+  return (2.*s3 - 3.*s2 + 1.)*ya + (s3 - 2.*s2 + s)*hs*fa +
+         (-2.*s3 + 3.*s2)*yb + (s3 - s2)*hs*fb;
+}
+
+/* The past before the oldest knot has left the ring once x0 has. */
+static int DDEForgotten(dde_data *data, double const t){
+  unsigned long first = data->knots - data->count;
+  return first && t < data->kx[first % data->cap];
+}
+
+static void DDELookup(dde_data *data, double const t, unsigned const cursor,
+                      double *out){
+  if(t < data->x0 || !data->count){
+    for(unsigned i = 0; i < data->eq_num; i++){
+      out[i] = data->history ? data->history(t, i, data->userdata) :
+                               data->y0[i];
+    }
+    return;
+  }
+  if(DDEForgotten(data, t)){
+    for(unsigned i = 0; i < data->eq_num; i++){
+      out[i] = NAN;
+    }
+    return;
+  }
+  unsigned long id = DDESegment(data, t, cursor);
+  for(unsigned i = 0; i < data->eq_num; i++){
+    out[i] = DDEHermite(data, id, t, i);
+  }
+}
+
+static void DDESystem(double const x, double const *Y, double *DY,
+                      void *userdata){
+  dde_data *data = userdata;
+  for(unsigned k = 0; k < data->delay_num; k++){
+    DDELookup(data, x - data->tau[k], k, &data->yd[k*data->eq_num]);
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    DY[i] = data->funcs[i](x, Y, data->yd, data->userdata);
+  }
+}
+
+void DDEStep(dde_data *data){
+  unsigned const n = data->eq_num;
+  double f[n];
+  double *y;
+  double x;
+  if(!data->count){
+    data->knots = 0;
+    memset(data->cursor, 0, sizeof(unsigned long)*(data->delay_num + 1));
+    DDESystem(data->x0, data->y0, f, data);
+    DDEPush(data, data->x0, data->y0, f);
+    RK4SetYs0(data->rk4, data->y0, n);
+    RK4SetX(data->rk4, data->x0);
+    RK5SetYs0(data->rk5, data->y0, n);
+    RK5SetX(data->rk5, data->x0);
+  }
+  if(DDE_RK4 == data->method){
+    RK4SetStep(data->rk4, data->h);
+    RK4Step(data->rk4);
+    y = RK4GetYs(data->rk4);
+    x = RK4GetX(data->rk4);
+  } else {
+    RK5SetStep(data->rk5, data->h);
+    RK5Step(data->rk5);
+    y = RK5GetYs(data->rk5);
+    x = RK5GetX(data->rk5);
+  }
+  DDESystem(x, y, f, data);
+  DDEPush(data, x, y, f);
+}
+
+double DDEGetY(dde_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return DDEGetYs(data)[num];
+}
+
+double *DDEGetYs(dde_data *data){
+  if(!data){
+    return NULL;
+  }
+  if(!data->count){
+    return data->y0;
+  }
+  return DDE_RK4 == data->method ? RK4GetYs(data->rk4) :
+                                   RK5GetYs(data->rk5);
+}
+
+double DDEGetX(dde_data *data){
+  if(!data){
+    return 0.;
+  }
+  if(!data->count){
+    return data->x0;
+  }
+  return DDE_RK4 == data->method ? RK4GetX(data->rk4) :
+                                   RK5GetX(data->rk5);
+}
+
+double DDEGetDY(dde_data *data, unsigned const num){
+  if(!data || num >= data->eq_num || !data->count){
+    return 0.;
+  }
+  return DDE_RK4 == data->method ? RK4GetDY(data->rk4, num) :
+                                   RK5GetDY(data->rk5, num);
+}
+
+double DDEGetDelayed(dde_data *data, double const t, unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0.;
+  }
+  if(t < data->x0 || !data->count){
+    return data->history ? data->history(t, index, data->userdata) :
+                           data->y0[index];
+  }
+  if(DDEForgotten(data, t)){
+    return NAN;
+  }
+  return DDEHermite(data, DDESegment(data, t, data->delay_num), t, index);
+}
+
+int DDESetUserData(dde_data *data, void *userdata){
+  if(data){
+    data->userdata = userdata;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,669 @@
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "stdint.h"
+#include "etd.h"
+
+/* ETDRK4 (Cox & Matthews 2002):
+ *   a = E2 u + Q N(u),  b = E2 u + Q N(a),  c = E2 a + Q (2 N(b) - N(u)),
+ *   u' = E u + F1 N(u) + F2 (N(a) + N(b)) + F3 N(c)
+ * with E = exp(hL), E2 = exp(hL/2), Q = h/2 phi1(hL/2),
+ * F1 = h (phi1 - 3 phi2 + 4 phi3), F2 = 2 h (phi2 - 2 phi3) and
+ * F3 = h (4 phi3 - phi2), all of hL. For diagonal L these are scalars
+ * per equation; small |z| use the Taylor series of phi_k to avoid the
+ * cancellation of the closed forms. For dense L the phi_k(hL) are the
+ * first block row of the exponential of the block matrix
+ * [[hL, I, 0, 0], [0, 0, I, 0], [0, 0, 0, I], [0, 0, 0, 0]]. For a
+ * matvec L every stage is one action of the exponential of an operator
+ * augmented the same way (Al-Mohy & Higham 2011), computed by Arnoldi
+ * with substeps where the projection error estimate is too large. */
+
+enum ETDMode {ETD_NONE, ETD_DIAGONAL, ETD_DENSE, ETD_MATVEC};
+
+enum ETDCoef {ETD_E, ETD_E2, ETD_Q, ETD_F1, ETD_F2, ETD_F3, ETD_COEFS};
+
+struct etd_data_st{
+  unsigned eq_num;
+  enum ETDMode mode;
+  double *y;
+  double x;
+  double h;
+  double *l;
+  double *coef;
+  double cached_h;
+  int cached;
+  ETDMatvecFunc matvec;
+  unsigned dim;
+  double tol;
+  double *kv;
+  double *kh;
+  ETDNonlinFunc nonlin;
+  void *userdata;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+#define ETD_MAX_SUBSTEPS 1000
+
+int ETDInitData(etd_data **data, unsigned const eq_num){
+  *data = calloc(1, sizeof(etd_data));
+  EXIT_IF_NULL(*data);
+  (*data)->eq_num = eq_num;
+  (*data)->y = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->y);
+  (*data)->dim = 30;
+  (*data)->tol = 1.E-10;
+  return 1;
+error:
+  if(*data){
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void ETDFreeData(etd_data *data){
+  if(data){
+    free(data->kh);
+    free(data->kv);
+    free(data->coef);
+    free(data->l);
+    free(data->y);
+    free(data);
+  }
+}
+
+int ETDSetYs0(etd_data *data, double const ys[],
+              unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->y[i] = ys[i];
+  }
+  return 1;
+}
+
+int ETDSetY0(etd_data *data, double const y, unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0;
+  }
+  data->y[index] = y;
+  return 1;
+}
+
+int ETDSetX(etd_data *data, double const t){
+  if(!data){
+    return 0;
+  }
+  data->x = t;
+  return 1;
+}
+
+int ETDSetStep(etd_data *data, double const step){
+  if(!data){
+    return 0;
+  }
+  data->h = step;
+  return 1;
+}
+
+static int ETDSetOperator(etd_data *data, double const l[],
+                          size_t const size, enum ETDMode const mode){
+  double *copy = malloc(sizeof(double)*size);
+  double *coef = malloc(sizeof(double)*size*ETD_COEFS);
+  if(!copy || !coef){
+    free(copy);
+    free(coef);
+    return 0;
+  }
+  memcpy(copy, l, sizeof(double)*size);
+  free(data->l);
+  free(data->coef);
+  data->l = copy;
+  data->coef = coef;
+  data->mode = mode;
+  data->cached = 0;
+  return 1;
+}
+
+int ETDSetDiagonal(etd_data *data, double const l[], unsigned const num){
+  if(!data || !l || num != data->eq_num){
+    return 0;
+  }
+  return ETDSetOperator(data, l, num, ETD_DIAGONAL);
+}
+
+int ETDSetDense(etd_data *data, double const l[], unsigned const num){
+  if(!data || !l || num != data->eq_num*data->eq_num){
+    return 0;
+  }
+  return ETDSetOperator(data, l, num, ETD_DENSE);
+}
+
+static int ETDKrylovAlloc(etd_data *data, unsigned const dim){
+  double *kv = malloc(sizeof(double)*(dim + 1)*(data->eq_num + 3));
+  double *kh = malloc(sizeof(double)*(dim + 1)*dim);
+  if(!kv || !kh){
+    free(kv);
+    free(kh);
+    return 0;
+  }
+  free(data->kv);
+  free(data->kh);
+  data->kv = kv;
+  data->kh = kh;
+  data->dim = dim;
+  return 1;
+}
+
+int ETDSetMatvec(etd_data *data, ETDMatvecFunc func){
+  if(!data || !func || !ETDKrylovAlloc(data, data->dim)){
+    return 0;
+  }
+  data->matvec = func;
+  data->mode = ETD_MATVEC;
+  return 1;
+}
+
+int ETDSetKrylov(etd_data *data, unsigned const dim, double const tol){
+  if(!data || !dim || tol <= 0.){
+    return 0;
+  }
+  if(data->kv && !ETDKrylovAlloc(data, dim)){
+    return 0;
+  }
+  data->dim = dim;
+  data->tol = tol;
+  return 1;
+}
+
+int ETDSetNonlinear(etd_data *data, ETDNonlinFunc func){
+  if(!data){
+    return 0;
+  }
+  data->nonlin = func;
+  return 1;
+}
+
+/* Bitwise, since -ffast-math lets the compiler assume isfinite(). */
+static int ETDFinite(double const v){
+  uint64_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  return (bits >> 52 & 0x7FF) != 0x7FF;
+}
+
+/* C = A B, all n x n row major. */
+static void ETDMatMul(double const *A, double const *B, double *C,
+                      unsigned const n){
+  memset(C, 0, sizeof(double)*n*n);
+  for(unsigned i = 0; i < n; i++){
+    for(unsigned k = 0; k < n; k++){
+      double a = A[i*n + k];
+      if(0. == a){
+        continue;
+      }
+      for(unsigned j = 0; j < n; j++){
+        C[i*n + j] += a*B[k*n + j];
+      }
+    }
+  }
+}
+
+/* E = exp(A) by the Taylor series of A / 2^s, |A / 2^s| <= 1/2, and s
+ * squarings. Returns 0 if A is not finite. */
+static int ETDExpm(double const *A, unsigned const n, double *E){
+  size_t nn = (size_t)n*n;
+  double *S = malloc(sizeof(double)*3*nn);
+  if(!S){
+    return 0;
+  }
+  double *T = S + nn, *U = T + nn;
+  double norm = 0.;
+  for(unsigned i = 0; i < n; i++){
+    double row = 0.;
+    for(unsigned j = 0; j < n; j++){
+      row += fabs(A[i*n + j]);
+    }
+    norm = row > norm ? row : norm;
+  }
+  if(!ETDFinite(norm)){
+    free(S);
+    return 0;
+  }
+  int s = 0;
+  while(norm > 0.5){
+    norm *= 0.5;
+    s++;
+  }
+  double scale = ldexp(1., -s);
+  memset(E, 0, sizeof(double)*nn);
+  memset(T, 0, sizeof(double)*nn);
+  for(size_t idx = 0; idx < nn; idx++){
+    S[idx] = A[idx]*scale;
+  }
+  for(unsigned i = 0; i < n; i++){
+    E[i*n + i] = 1.;
+    T[i*n + i] = 1.;
+  }
+  for(unsigned k = 1; k <= 30; k++){
+    double tmax = 0.;
+    ETDMatMul(T, S, U, n);
+    for(size_t idx = 0; idx < nn; idx++){
+      T[idx] = U[idx] / k;
+      E[idx] += T[idx];
+      tmax = fabs(T[idx]) > tmax ? fabs(T[idx]) : tmax;
+    }
+    if(tmax < 1.E-18){
+      break;
+    }
+  }
+  for(int j = 0; j < s; j++){
+    ETDMatMul(E, E, U, n);
+    memcpy(E, U, sizeof(double)*nn);
+  }
+  free(S);
+  return 1;
+}
+
+static void ETDPhiScalar(double const z, double phi[4]){
+  if(fabs(z) < 1.){
+    double fact[4] = {1., 1., 2., 6.};
+    for(unsigned k = 0; k < 4; k++){
+      double term = 1. / fact[k];
+      phi[k] = 0.;
+      for(unsigned j = 0; j < 20; j++){
+        phi[k] += term;
+        term *= z / (j + k + 1);
+      }
+    }
+    return;
+  }
+  phi[0] = exp(z);
+  phi[1] = (phi[0] - 1.) / z;
+  phi[2] = (phi[1] - 1.) / z;
+  phi[3] = (phi[2] - 0.5) / z;
+}
+
+static void ETDCombine(double const h, double const phi[4],
+                       double const phih[2], double *coef[ETD_COEFS],
+                       size_t const idx){
+  coef[ETD_E][idx] = phi[0];
+  coef[ETD_E2][idx] = phih[0];
+  coef[ETD_Q][idx] = 0.5*h*phih[1];
+  coef[ETD_F1][idx] = h*(phi[1] - 3.*phi[2] + 4.*phi[3]);
+  coef[ETD_F2][idx] = 2.*h*(phi[2] - 2.*phi[3]);
+  coef[ETD_F3][idx] = h*(4.*phi[3] - phi[2]);
+}
+
+static int ETDPrepareDense(etd_data *data){
+  unsigned n = data->eq_num;
+  size_t nn = (size_t)n*n;
+  unsigned n4 = 4*n, n2 = 2*n;
+  double *W = calloc((size_t)n4*n4, sizeof(double));
+  double *X = malloc(sizeof(double)*n4*n4);
+  double *coef[ETD_COEFS];
+  if(!W || !X){
+    goto error;
+  }
+  for(unsigned c = 0; c < ETD_COEFS; c++){
+    coef[c] = data->coef + c*nn;
+  }
+  for(unsigned i = 0; i < n; i++){
+    for(unsigned j = 0; j < n; j++){
+      W[i*n4 + j] = data->h*data->l[i*n + j];
+    }
+    for(unsigned b = 0; b < 3; b++){
+      W[(b*n + i)*n4 + (b + 1)*n + i] = 1.;
+    }
+  }
+  if(!ETDExpm(W, n4, X)){
+    goto error;
+  }
+  for(unsigned i = 0; i < n; i++){
+    for(unsigned j = 0; j < n; j++){
+      double phi[4] = {X[i*n4 + j], X[i*n4 + n + j],
+                       X[i*n4 + 2*n + j], X[i*n4 + 3*n + j]};
+      double phih[2] = {0., 0.};
+      ETDCombine(data->h, phi, phih, coef, i*n + j);
+    }
+  }
+  memset(W, 0, sizeof(double)*n2*n2);
+  for(unsigned i = 0; i < n; i++){
+    for(unsigned j = 0; j < n; j++){
+      W[i*n2 + j] = 0.5*data->h*data->l[i*n + j];
+    }
+    W[i*n2 + n + i] = 1.;
+  }
+  if(!ETDExpm(W, n2, X)){
+    goto error;
+  }
+  for(unsigned i = 0; i < n; i++){
+    for(unsigned j = 0; j < n; j++){
+      coef[ETD_E2][i*n + j] = X[i*n2 + j];
+      coef[ETD_Q][i*n + j] = 0.5*data->h*X[i*n2 + n + j];
+    }
+  }
+  free(W);
+  free(X);
+  return 1;
+error:
+  free(W);
+  free(X);
+  return 0;
+}
+
+static int ETDPrepare(etd_data *data){
+  if(data->mode == ETD_MATVEC ||
+     (data->cached && data->cached_h == data->h)){
+    return 1;
+  }
+  if(data->mode == ETD_DENSE){
+    if(!ETDPrepareDense(data)){
+      return 0;
+    }
+  } else {
+    double *coef[ETD_COEFS];
+    for(unsigned c = 0; c < ETD_COEFS; c++){
+      coef[c] = data->coef + c*data->eq_num;
+    }
+    for(unsigned i = 0; i < data->eq_num; i++){
+      double phi[4], phih[4];
+      ETDPhiScalar(data->h*data->l[i], phi);
+      ETDPhiScalar(0.5*data->h*data->l[i], phih);
+      ETDCombine(data->h, phi, phih, coef, i);
+    }
+  }
+  data->cached = 1;
+  data->cached_h = data->h;
+  return 1;
+}
+
+int ETDCheck(etd_data *data){
+  if(!data || !data->eq_num){
+    fprintf(stderr, "%s\n", "ETDCheck: Incorrect initialization.");
+    return 0;
+  }
+  if(data->h <= 0.){
+    fprintf(stderr, "%s\n", "ETDCheck: Step must be greater then 0.");
+    return 0;
+  }
+  if(ETD_NONE == data->mode){
+    fprintf(stderr, "%s\n", "ETDCheck: Linear operator not assigned.");
+    return 0;
+  }
+  if(!data->nonlin){
+    fprintf(stderr, "%s\n", "ETDCheck: Nonlinear function not assigned.");
+    return 0;
+  }
+  if(!ETDPrepare(data)){
+    fprintf(stderr, "%s\n", "ETDCheck: Phi functions of h L not computable.");
+    return 0;
+  }
+  return 1;
+}
+
+/* out (+)= C v for coefficient c. */
+static void ETDApply(etd_data *data, enum ETDCoef const c, double const *v,
+                     double *out, int const add){
+  unsigned n = data->eq_num;
+  if(data->mode == ETD_DIAGONAL){
+    double const *m = data->coef + (size_t)c*n;
+    for(unsigned i = 0; i < n; i++){
+      out[i] = (add ? out[i] : 0.) + m[i]*v[i];
+    }
+    return;
+  }
+  double const *m = data->coef + (size_t)c*n*n;
+  for(unsigned i = 0; i < n; i++){
+    double sum = 0.;
+    for(unsigned j = 0; j < n; j++){
+      sum += m[i*n + j]*v[j];
+    }
+    out[i] = (add ? out[i] : 0.) + sum;
+  }
+}
+
+static void ETDCachedStep(etd_data *data){
+  unsigned n = data->eq_num;
+  double nu[n], na[n], nb[n], nc[n], eu[n], a[n], b[n], c[n], t[n];
+  double h05 = 0.5*data->h;
+  data->nonlin(data->x, data->y, nu, data->userdata);
+  ETDApply(data, ETD_E2, data->y, eu, 0);
+  memcpy(a, eu, sizeof(double)*n);
+  ETDApply(data, ETD_Q, nu, a, 1);
+  data->nonlin(data->x + h05, a, na, data->userdata);
+  memcpy(b, eu, sizeof(double)*n);
+  ETDApply(data, ETD_Q, na, b, 1);
+  data->nonlin(data->x + h05, b, nb, data->userdata);
+  for(unsigned i = 0; i < n; i++){
+    t[i] = 2.*nb[i] - nu[i];
+  }
+  ETDApply(data, ETD_E2, a, c, 0);
+  ETDApply(data, ETD_Q, t, c, 1);
+  data->nonlin(data->x + data->h, c, nc, data->userdata);
+  ETDApply(data, ETD_E, data->y, t, 0);
+  ETDApply(data, ETD_F1, nu, t, 1);
+  for(unsigned i = 0; i < n; i++){
+    na[i] += nb[i];
+  }
+  ETDApply(data, ETD_F2, na, t, 1);
+  ETDApply(data, ETD_F3, nc, t, 1);
+  memcpy(data->y, t, sizeof(double)*n);
+}
+
+/* y = A x for the augmented operator A = [[scale L, W], [0, J]] of
+ * size n + p, W = [v_p .. v_1], J the upward shift. */
+static void ETDAugmented(etd_data *data, double const scale,
+                         double const *const v[], unsigned const p,
+                         double const *x, double *y){
+  unsigned n = data->eq_num;
+  data->matvec(x, y, data->userdata);
+  for(unsigned i = 0; i < n; i++){
+    y[i] *= scale;
+  }
+  for(unsigned j = 0; j < p; j++){
+    double eta = x[n + j];
+    if(0. != eta){
+      for(unsigned i = 0; i < n; i++){
+        y[i] += eta*v[p - j][i];
+      }
+    }
+    y[n + j] = j + 1 < p ? x[n + j + 1] : 0.;
+  }
+}
+
+/* out = sum_{k <= p} phi_k(scale L) v[k]. Returns 0 on a non-finite
+ * Krylov basis or error estimate, or after ETD_MAX_SUBSTEPS substeps. */
+static int ETDPhiAction(etd_data *data, double const scale,
+                        double const *const v[], unsigned const p,
+                        double *out){
+  unsigned n = data->eq_num, na = n + p, m = data->dim;
+  double *V = data->kv, *H = data->kh;
+  double w[na];
+  double t = 0.;
+  unsigned substeps = 0;
+  memcpy(w, v[0], sizeof(double)*n);
+  for(unsigned j = 0; j < p; j++){
+    w[n + j] = j + 1 == p ? 1. : 0.;
+  }
+  while(t < 1.){
+    if(substeps++ == ETD_MAX_SUBSTEPS){
+      return 0;
+    }
+    double beta = 0.;
+    for(unsigned i = 0; i < na; i++){
+      beta += w[i]*w[i];
+    }
+    beta = sqrt(beta);
+    if(!ETDFinite(beta)){
+      return 0;
+    }
+    if(0. == beta){
+      break;
+    }
+    for(unsigned i = 0; i < na; i++){
+      V[i] = w[i] / beta;
+    }
+    memset(H, 0, sizeof(double)*(m + 1)*m);
+    unsigned k = m;
+    int exact = 0;
+    for(unsigned j = 0; j < m; j++){
+      double *vn = V + (size_t)(j + 1)*na;
+      ETDAugmented(data, scale, v, p, V + (size_t)j*na, vn);
+      for(unsigned i = 0; i <= j; i++){
+        double dot = 0.;
+        for(unsigned r = 0; r < na; r++){
+          dot += V[(size_t)i*na + r]*vn[r];
+        }
+        H[i*m + j] = dot;
+        for(unsigned r = 0; r < na; r++){
+          vn[r] -= dot*V[(size_t)i*na + r];
+        }
+      }
+      double norm = 0.;
+      for(unsigned r = 0; r < na; r++){
+        norm += vn[r]*vn[r];
+      }
+      norm = sqrt(norm);
+      if(!ETDFinite(norm)){
+        return 0;
+      }
+      H[(j + 1)*m + j] = norm;
+      if(norm < 1.E-12*beta){
+        k = j + 1;
+        exact = 1;
+        break;
+      }
+      for(unsigned r = 0; r < na; r++){
+        vn[r] /= norm;
+      }
+    }
+    double tau = 1. - t;
+    double Hk[k*k], F[k*k];
+    for(;;){
+      for(unsigned i = 0; i < k; i++){
+        for(unsigned j = 0; j < k; j++){
+          Hk[i*k + j] = tau*H[i*m + j];
+        }
+      }
+      if(!ETDExpm(Hk, k, F)){
+        return 0;
+      }
+      double err = beta*tau*H[k*m + k - 1]*fabs(F[(k - 1)*k]);
+      if(!ETDFinite(err)){
+        return 0;
+      }
+      if(exact || err <= data->tol*beta || tau < 1.E-12){
+        break;
+      }
+      tau *= 0.5;
+    }
+    memset(w, 0, sizeof(double)*na);
+    for(unsigned j = 0; j < k; j++){
+      double c = beta*F[j*k];
+      for(unsigned r = 0; r < na; r++){
+        w[r] += c*V[(size_t)j*na + r];
+      }
+    }
+    t += tau;
+  }
+  memcpy(out, w, sizeof(double)*n);
+  return 1;
+}
+
+static int ETDKrylovStep(etd_data *data){
+  unsigned n = data->eq_num;
+  double nu[n], na[n], nb[n], nc[n], a[n], b[n], c[n];
+  double v1[n], v2[n], v3[n];
+  double h = data->h, h05 = 0.5*data->h;
+  data->nonlin(data->x, data->y, nu, data->userdata);
+  for(unsigned i = 0; i < n; i++){
+    v1[i] = h05*nu[i];
+  }
+  double const *va[] = {data->y, v1};
+  if(!ETDPhiAction(data, h05, va, 1, a)){
+    return 0;
+  }
+  data->nonlin(data->x + h05, a, na, data->userdata);
+  for(unsigned i = 0; i < n; i++){
+    v1[i] = h05*na[i];
+  }
+  if(!ETDPhiAction(data, h05, va, 1, b)){
+    return 0;
+  }
+  data->nonlin(data->x + h05, b, nb, data->userdata);
+  for(unsigned i = 0; i < n; i++){
+    v1[i] = h05*(2.*nb[i] - nu[i]);
+  }
+  double const *vc[] = {a, v1};
+  if(!ETDPhiAction(data, h05, vc, 1, c)){
+    return 0;
+  }
+  data->nonlin(data->x + h, c, nc, data->userdata);
+  for(unsigned i = 0; i < n; i++){
+    v1[i] = h*nu[i];
+    v2[i] = h*(-3.*nu[i] + 2.*na[i] + 2.*nb[i] - nc[i]);
+    v3[i] = 4.*h*(nu[i] - na[i] - nb[i] + nc[i]);
+  }
+  double const *vu[] = {data->y, v1, v2, v3};
+  if(!ETDPhiAction(data, h, vu, 3, a)){
+    return 0;
+  }
+  memcpy(data->y, a, sizeof(double)*n);
+  return 1;
+}
+
+int ETDStep(etd_data *data){
+  if(data->mode == ETD_MATVEC){
+    if(!ETDKrylovStep(data)){
+      return 0;
+    }
+  } else {
+    if(!ETDPrepare(data)){
+      return 0;
+    }
+    ETDCachedStep(data);
+  }
+  data->x += data->h;
+  return 1;
+}
+
+int ETDStepN(etd_data *data, unsigned const n){
+  for(unsigned i = 0; i < n; i++){
+    if(!ETDStep(data)){
+      return 0;
+    }
+  }
+  return 1;
+}
+
+double ETDGetY(etd_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->y[num];
+}
+
+double *ETDGetYs(etd_data *data){
+  if(data){
+    return data->y;
+  }
+  return NULL;
+}
+
+double ETDGetX(etd_data *data){
+  if(data){
+    return data->x;
+  }
+  return 0.;
+}
+
+int ETDSetUserData(etd_data *data, void *userdata){
+  if(data){
+    data->userdata = userdata;
+    return 1;
+  }
+  return 0;
+}
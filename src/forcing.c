@@ -0,0 +1,277 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "fcntl.h"
+#include "unistd.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "forcing.h"
+
+/* The cursor segment is found by galloping from the previous one, and
+ * the Hermite data of the current segment (end values and end slopes
+ * scaled by the segment width) is kept for all channels, so the several
+ * stage lookups of a step falling into one segment cost only the
+ * polynomial evaluation. Moving to a new segment prefetches rows ahead,
+ * and for a mapped file crossing into a new 1 MiB window asks the kernel
+ * to read the next window in. */
+
+struct forcing_data_st{
+  unsigned channels;
+  size_t rows;
+  size_t stride;
+  double const *table;
+  void *map;
+  size_t map_len;
+  size_t window;
+  enum ForcingInterp interp;
+  size_t cursor;
+  size_t seg;
+  double *coef;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+#define FORCING_AHEAD 16
+#define FORCING_WINDOW ((size_t)1 << 20)
+
+static int ForcingInit(forcing_data **data, double const *table,
+                       size_t const rows, unsigned const channels){
+  if(rows < 2 || !channels){
+    return 0;
+  }
+  *data = calloc(1, sizeof(forcing_data));
+  EXIT_IF_NULL(*data);
+  (*data)->coef = calloc(4*channels, sizeof(double));
+  EXIT_IF_NULL((*data)->coef);
+  (*data)->channels = channels;
+  (*data)->rows = rows;
+  (*data)->stride = channels + 1;
+  (*data)->table = table;
+  (*data)->seg = rows;
+  (*data)->window = (size_t)-1;
+  (*data)->interp = FORCING_LINEAR;
+  return 1;
+error:
+  if(*data){
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+int ForcingInitTable(forcing_data **data, double const *table,
+                     size_t const rows, unsigned const channels){
+  if(!table){
+    return 0;
+  }
+  return ForcingInit(data, table, rows, channels);
+}
+
+int ForcingInitFile(forcing_data **data, char const *path,
+                    unsigned const channels){
+  struct stat st;
+  size_t row_size = sizeof(double)*(channels + 1);
+  int fd = open(path, O_RDONLY);
+  if(fd < 0){
+    return 0;
+  }
+  if(fstat(fd, &st) || !st.st_size || st.st_size % row_size){
+    close(fd);
+    return 0;
+  }
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(MAP_FAILED == map){
+    return 0;
+  }
+  if(!ForcingInit(data, map, st.st_size / row_size, channels)){
+    munmap(map, st.st_size);
+    return 0;
+  }
+  (*data)->map = map;
+  (*data)->map_len = st.st_size;
+  return 1;
+}
+
+void ForcingFreeData(forcing_data *data){
+  if(data){
+    if(data->map){
+      munmap(data->map, data->map_len);
+    }
+    free(data->coef);
+    free(data);
+  }
+}
+
+int ForcingSetInterp(forcing_data *data, enum ForcingInterp const interp){
+  if(!data || (interp != FORCING_LINEAR && interp != FORCING_CUBIC &&
+               interp != FORCING_AKIMA)){
+    return 0;
+  }
+  data->interp = interp;
+  data->seg = data->rows;
+  return 1;
+}
+
+#define FX(K) (data->table[(K)*data->stride])
+#define FV(K, C) (data->table[(K)*data->stride + 1 + (C)])
+
+/* Segment k with x_k <= x < x_k+1, clamped to the table. Gallops from
+ * the cursor and then bisects, so a move by d segments costs O(log d). */
+static size_t ForcingLocate(forcing_data *data, double const x){
+  size_t last = data->rows - 2;
+  size_t k = data->cursor;
+  size_t lo, hi, step = 1;
+  if(FX(k) <= x){
+    if(k == last || x < FX(k + 1)){
+      return k;
+    }
+    lo = k + 1;
+    while(lo + step <= last && FX(lo + step) <= x){
+      lo += step;
+      step *= 2;
+    }
+    hi = lo + step <= last + 1 ? lo + step : last + 1;
+  } else {
+    if(!k){
+      return 0;
+    }
+    hi = k;
+    while(hi >= step && FX(hi - step) > x){
+      hi -= step;
+      step *= 2;
+    }
+    lo = hi >= step ? hi - step : 0;
+    if(FX(lo) > x){
+      return 0;
+    }
+  }
+  /* FX(lo) <= x < FX(hi) */
+  while(hi - lo > 1){
+    size_t mid = lo + (hi - lo) / 2;
+    if(FX(mid) <= x){
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/* Slope of segment k, extended past both ends as in Akima (1970). */
+static double ForcingSegSlope(forcing_data *data, long const k,
+                              unsigned const c){
+  long last = (long)data->rows - 2;
+  if(!last){
+    return (FV(1, c) - FV(0, c)) / (FX(1) - FX(0));
+  }
+  if(k < 0){
+    return 2.*ForcingSegSlope(data, k + 1, c) -
+           ForcingSegSlope(data, k + 2, c);
+  }
+  if(k > last){
+    return 2.*ForcingSegSlope(data, k - 1, c) -
+           ForcingSegSlope(data, k - 2, c);
+  }
+  return (FV(k + 1, c) - FV(k, c)) / (FX(k + 1) - FX(k));
+}
+
+static double ForcingKnotSlope(forcing_data *data, size_t const i,
+                               unsigned const c){
+  if(data->interp == FORCING_CUBIC){
+    size_t a = i ? i - 1 : 0;
+    size_t b = i + 1 < data->rows ? i + 1 : i;
+    return (FV(b, c) - FV(a, c)) / (FX(b) - FX(a));
+  }
+  double m0 = ForcingSegSlope(data, (long)i - 2, c);
+  double m1 = ForcingSegSlope(data, (long)i - 1, c);
+  double m2 = ForcingSegSlope(data, (long)i, c);
+  double m3 = ForcingSegSlope(data, (long)i + 1, c);
+  double w1 = fabs(m3 - m2), w2 = fabs(m1 - m0);
+  if(w1 + w2 == 0.){
+    return 0.5*(m1 + m2);
+  }
+  return (w1*m1 + w2*m2) / (w1 + w2);
+}
+
+static void ForcingPrefetch(forcing_data *data, size_t const k){
+  size_t ahead = k + FORCING_AHEAD < data->rows ? k + FORCING_AHEAD :
+                                                  data->rows - 1;
+  __builtin_prefetch(data->table + ahead*data->stride);
+  if(data->map){
+    size_t window = k*data->stride*sizeof(double) / FORCING_WINDOW;
+    if(window != data->window){
+      size_t next = (window + 1)*FORCING_WINDOW;
+      data->window = window;
+      if(next < data->map_len){
+        size_t len = data->map_len - next < FORCING_WINDOW ?
+                     data->map_len - next : FORCING_WINDOW;
+        posix_madvise((char *)data->map + next, len, POSIX_MADV_WILLNEED);
+      }
+    }
+  }
+}
+
+static void ForcingSegment(forcing_data *data, size_t const k){
+  double dx = FX(k + 1) - FX(k);
+  for(unsigned c = 0; c < data->channels; c++){
+    double *coef = data->coef + 4*c;
+    coef[0] = FV(k, c);
+    coef[1] = FV(k + 1, c);
+    if(data->interp != FORCING_LINEAR){
+      coef[2] = dx*ForcingKnotSlope(data, k, c);
+      coef[3] = dx*ForcingKnotSlope(data, k + 1, c);
+    }
+  }
+  data->seg = k;
+  ForcingPrefetch(data, k);
+}
+
+static double ForcingEval(forcing_data *data, double const t,
+                          unsigned const c){
+  double const *coef = data->coef + 4*c;
+  if(data->interp == FORCING_LINEAR){
+    return coef[0] + t*(coef[1] - coef[0]);
+  }
+  double s = 1. - t;
+  return coef[0]*(1. + 2.*t)*s*s + coef[2]*t*s*s +
+         coef[1]*t*t*(3. - 2.*t) - coef[3]*t*t*s;
+}
+
+/* Moves the cursor to x and returns the local coordinate in [0, 1]. */
+static double ForcingSeek(forcing_data *data, double const x){
+  size_t k = ForcingLocate(data, x);
+  data->cursor = k;
+  if(k != data->seg){
+    ForcingSegment(data, k);
+  }
+  double t = (x - FX(k)) / (FX(k + 1) - FX(k));
+  return t < 0. ? 0. : (t > 1. ? 1. : t);
+}
+
+double ForcingGet(forcing_data *data, double const x, unsigned const channel){
+  if(!data || channel >= data->channels){
+    return 0.;
+  }
+  return ForcingEval(data, ForcingSeek(data, x), channel);
+}
+
+int ForcingGets(forcing_data *data, double const x, double *values){
+  if(!data || !values){
+    return 0;
+  }
+  double t = ForcingSeek(data, x);
+  for(unsigned c = 0; c < data->channels; c++){
+    values[c] = ForcingEval(data, t, c);
+  }
+  return 1;
+}
+
+size_t ForcingGetRows(forcing_data *data){
+  if(data){
+    return data->rows;
+  }
+  return 0;
+}
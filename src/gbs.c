@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "stdint.h"
+#include "gbs.h"
+#include "pool.h"
+
+/* Gragg-Bulirsch-Stoer extrapolation with the harmonic sequence
+ * n_j = 2(j + 1). The modified midpoint sequences of one step are
+ * independent and run as separate pool tasks, largest first. */
+
+#define KMAX 8
+#define GBS_MAX_REJECTS 64
+
+struct gbs_data_st{
+  unsigned eq_num;
+  double *y;
+  double *f;
+  double *f0;
+  double *t;
+  double *z;
+  double x;
+  double h;
+  double atol;
+  double rtol;
+  unsigned k;
+  unsigned seqs;
+  double step_h;
+  pool_data *pool;
+  GBSRSFunc *funcs;
+  void *userdata;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+static unsigned GBSSeq(unsigned const j){
+  return 2*(j + 1);
+}
+
+int GBSInitData(gbs_data **data, unsigned const eq_num){
+  *data = calloc(1, sizeof(gbs_data));
+  EXIT_IF_NULL(*data);
+  (*data)->eq_num = eq_num;
+  (*data)->y = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->y);
+  (*data)->f = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->f);
+  (*data)->f0 = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->f0);
+  (*data)->t = calloc(eq_num*(KMAX + 1), sizeof(double));
+  EXIT_IF_NULL((*data)->t);
+  (*data)->z = calloc(3*eq_num*(KMAX + 1), sizeof(double));
+  EXIT_IF_NULL((*data)->z);
+  (*data)->funcs = calloc(eq_num, sizeof(GBSRSFunc));
+  EXIT_IF_NULL((*data)->funcs);
+  if(!PoolInitData(&(*data)->pool, 1)){
+    goto error;
+  }
+  (*data)->atol = 1.E-10;
+  (*data)->rtol = 1.E-10;
+  (*data)->k = 4;
+  return 1;
+error:
+  if(*data){
+    free((*data)->funcs);
+    free((*data)->z);
+    free((*data)->t);
+    free((*data)->f0);
+    free((*data)->f);
+    free((*data)->y);
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void GBSFreeData(gbs_data *data){
+  if(data){
+    PoolFreeData(data->pool);
+    free(data->funcs);
+    free(data->z);
+    free(data->t);
+    free(data->f0);
+    free(data->f);
+    free(data->y);
+    free(data);
+  }
+}
+
+int GBSSetYs0(gbs_data *data, double const ys[],
+              unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->y[i] = ys[i];
+  }
+  return 1;
+}
+
+int GBSSetY0(gbs_data *data, double const y, unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0;
+  }
+  data->y[index] = y;
+  return 1;
+}
+
+int GBSSetX(gbs_data *data, double const t){
+  if(!data){
+    return 0;
+  }
+  data->x = t;
+  return 1;
+}
+
+int GBSSetStep(gbs_data *data, double const step){
+  if(!data){
+    return 0;
+  }
+  data->h = step;
+  return 1;
+}
+
+int GBSSetTolerance(gbs_data *data, double const atol, double const rtol){
+  if(!data || atol < 0. || rtol < 0. || (0. == atol && 0. == rtol)){
+    return 0;
+  }
+  data->atol = atol;
+  data->rtol = rtol;
+  return 1;
+}
+
+int GBSSetThreads(gbs_data *data, unsigned const threads){
+  pool_data *pool;
+  if(!data || !threads || !PoolInitData(&pool, threads)){
+    return 0;
+  }
+  PoolFreeData(data->pool);
+  data->pool = pool;
+  return 1;
+}
+
+int GBSSetEquation(gbs_data *data, GBSRSFunc func,
+                   unsigned const index){
+  if(!data || index >= data->eq_num){
+      return 0;
+    }
+  data->funcs[index] = func;
+  return 1;
+}
+
+int GBSSetEquations(gbs_data *data, GBSRSFunc func[],
+                    unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->funcs[i] = func[i];
+  }
+  return 1;
+}
+
+int GBSCheck(gbs_data *data){
+  if(!data || !data->eq_num){
+    fprintf(stderr, "%s\n", "GBSCheck: Incorrect initialization.");
+    return 0;
+  }
+  if(data->h <= 0.){
+    fprintf(stderr, "%s\n", "GBSCheck: Step must be greater then 0.");
+    return 0;
+  }
+  for(unsigned i = 0; i< data->eq_num; i++){
+    if(!data->funcs[i]){
+      fprintf(stderr, "%s%d%s\n", "GBSCheck: Right side functions for parameter number ", i, " not assigned.");
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Modified midpoint rule with n_j substeps and Gragg's smoothing. */
+static void GBSMidpoint(unsigned const task, unsigned const thread,
+                        void *arg){
+  gbs_data *data = arg;
+  unsigned const n = data->eq_num;
+  unsigned const j = data->seqs - 1 - task;
+  unsigned const steps = GBSSeq(j);
+  double const hs = data->step_h/steps;
+  double *z0 = &data->z[3*n*j];
+  double *z1 = z0 + n;
+  double *dz = z1 + n;
+  double *res = &data->t[n*j];
+  for(unsigned i = 0; i < n; i++){
+    z0[i] = data->y[i];
+    z1[i] = data->y[i] + hs*data->f0[i];
+  }
+  for(unsigned m = 1; m <= steps; m++){
+    double xm = data->x + m*hs;
+    for(unsigned i = 0; i < n; i++){
+      dz[i] = data->funcs[i](xm, z1, data->userdata);
+    }
+    if(m == steps){
+      break;
+    }
+    for(unsigned i = 0; i < n; i++){
+      double z2 = z0[i] + 2.*hs*dz[i];
+      z0[i] = z1[i];
+      z1[i] = z2;
+    }
+  }
+  for(unsigned i = 0; i < n; i++){
+    res[i] = 0.5*(z0[i] + z1[i] + hs*dz[i]);
+  }
+}
+
+/* Bitwise, since -ffast-math lets the compiler assume isfinite(). */
+static int GBSFinite(double const v){
+  uint64_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  return (bits >> 52 & 0x7FF) != 0x7FF;
+}
+
+static double GBSStepFactor(double const err, unsigned const j){
+  if(!GBSFinite(err)){
+    return 0.25;
+  }
+  double fac = err > 0. ? 0.94*pow(0.65/err, 1./(2*j + 1)) : 4.;
+  return fac < 0.02 ? 0.02 : (fac > 4. ? 4. : fac);
+}
+
+static double GBSWork(gbs_data *data, unsigned const j){
+  double work = 1.;
+  if(PoolGetThreads(data->pool) > j){
+    return work + GBSSeq(j);
+  }
+  for(unsigned i = 0; i <= j; i++){
+    work += GBSSeq(i);
+  }
+  return work;
+}
+
+int GBSStep(gbs_data *data){
+  unsigned const n = data->eq_num;
+  double const h0 = data->h;
+  unsigned const k0 = data->k;
+  double ynew[n], ylow[n];
+  for(unsigned i = 0; i < n; i++){
+    data->f0[i] = data->funcs[i](data->x, data->y, data->userdata);
+  }
+  for(unsigned rejects = 0; rejects < GBS_MAX_REJECTS; rejects++){
+    unsigned k = data->k;
+    double err[KMAX + 1];
+    data->step_h = data->h;
+    data->seqs = k + 1;
+    PoolRun(data->pool, GBSMidpoint, data->seqs, data);
+    memset(err, 0, sizeof(err));
+    for(unsigned i = 0; i < n; i++){
+      double row[KMAX + 1], prev[KMAX + 1];
+      for(unsigned j = 0; j <= k; j++){
+        row[0] = data->t[n*j + i];
+        for(unsigned l = 1; l <= j; l++){
+          double r = (double)GBSSeq(j)/GBSSeq(j - l);
+          row[l] = row[l - 1] + (row[l - 1] - prev[l - 1])/(r*r - 1.);
+        }
+        if(j){
+          double sc = data->atol + data->rtol*fmax(fabs(data->y[i]),
+                                                   fabs(row[j]));
+          double e = (row[j] - row[j - 1])/sc;
+          err[j] += e*e;
+        }
+        if(j == k - 1){
+          ylow[i] = row[j];
+        }
+        memcpy(prev, row, sizeof(double)*(j + 1));
+      }
+      ynew[i] = row[k];
+    }
+    for(unsigned j = 1; j <= k; j++){
+      err[j] = sqrt(err[j]/n);
+    }
+    double hk = data->h*GBSStepFactor(err[k], k);
+    double hk1 = data->h*GBSStepFactor(err[k - 1], k - 1);
+    double wk = GBSWork(data, k)/hk;
+    double wk1 = GBSWork(data, k - 1)/hk1;
+    if(GBSFinite(err[k]) && err[k] <= 1.){
+      double h = data->h;
+      for(unsigned i = 0; i < n; i++){
+        data->f[i] = (ynew[i] - data->y[i])/h;
+        data->y[i] = ynew[i];
+      }
+      data->x += h;
+      if(k > 2 && wk1 < 0.8*wk){
+        data->k = k - 1;
+        data->h = hk1;
+      } else if(k < KMAX && wk < 0.9*wk1){
+        data->k = k + 1;
+        data->h = hk*GBSWork(data, k + 1)/GBSWork(data, k);
+      } else {
+        data->h = hk;
+      }
+      return 1;
+    }
+    if(GBSFinite(err[k - 1]) && err[k - 1] <= 1.){
+      double h = data->h;
+      for(unsigned i = 0; i < n; i++){
+        data->f[i] = (ylow[i] - data->y[i])/h;
+        data->y[i] = ylow[i];
+      }
+      data->x += h;
+      data->k = k > 2 ? k - 1 : k;
+      data->h = hk1;
+      return 1;
+    }
+    data->h = fmin(hk, hk1);
+    if(k > 2 && wk1 < 0.8*wk){
+      data->k = k - 1;
+    }
+  }
+  data->h = h0;
+  data->k = k0;
+  return 0;
+}
+
+int GBSIntegrate(gbs_data *data, double const x_end){
+  while(data->x < x_end){
+    double h = data->h;
+    double x0 = data->x;
+    int last = x0 + h >= x_end;
+    if(last){
+      data->h = x_end - x0;
+    }
+    double hl = data->h;
+    if(!GBSStep(data)){
+      data->h = h;
+      return 0;
+    }
+    if(last && data->x == x0 + hl){
+      data->x = x_end;
+      data->h = data->h > h ? data->h : h;
+    }
+  }
+  return 1;
+}
+
+double GBSGetY(gbs_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->y[num];
+}
+
+double *GBSGetYs(gbs_data *data){
+  if(data){
+    return data->y;
+  }
+  return NULL;
+}
+
+double GBSGetX(gbs_data *data){
+  if(data){
+    return data->x;
+  }
+  return 0.;
+}
+
+double GBSGetDY(gbs_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->f[num];
+}
+
+double GBSGetStep(gbs_data *data){
+  if(data){
+    return data->h;
+  }
+  return 0.;
+}
+
+unsigned GBSGetOrder(gbs_data *data){
+  if(data){
+    return 2*data->k + 2;
+  }
+  return 0;
+}
+
+int GBSSetUserData(gbs_data *data, void *userdata){
+  if(data){
+    data->userdata = userdata;
+    return 1;
+  }
+  return 0;
+}
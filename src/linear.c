@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "linear.h"
+
+/* Classic RK4 for y' = A y + b(x). A stage never stores its slope k:
+ * each row computes k_i = (A z)_i + b_i and immediately writes the next
+ * stage value y_i + c h k_i and the running weighted sum of slopes, so
+ * a stage streams A, z and y once. The sum ends up as dy of the step. */
+
+struct linear_data_st{
+  unsigned eq_num;
+  unsigned *row_ptr;
+  unsigned *cols;
+  double *vals;
+  double *y;
+  double *f;
+  double *za;
+  double *zb;
+  double *b;
+  double x;
+  double h;
+  LinearForceFunc force;
+  pool_data *pool;
+  unsigned *part;
+  unsigned stage;
+  void *userdata;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+int LinearInitData(linear_data **data, unsigned const eq_num){
+  *data = calloc(1, sizeof(linear_data));
+  EXIT_IF_NULL(*data);
+  (*data)->eq_num = eq_num;
+  (*data)->y = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->y);
+  (*data)->f = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->f);
+  (*data)->za = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->za);
+  (*data)->zb = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->zb);
+  (*data)->b = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->b);
+  (*data)->part = calloc(2, sizeof(unsigned));
+  EXIT_IF_NULL((*data)->part);
+  return 1;
+error:
+  if(*data){
+    free((*data)->b);
+    free((*data)->zb);
+    free((*data)->za);
+    free((*data)->f);
+    free((*data)->y);
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void LinearFreeData(linear_data *data){
+  if(data){
+    free(data->part);
+    free(data->vals);
+    free(data->cols);
+    free(data->row_ptr);
+    free(data->b);
+    free(data->zb);
+    free(data->za);
+    free(data->f);
+    free(data->y);
+    free(data);
+  }
+}
+
+/* Row bounds splitting the nonzeros (plus one per row for the vector
+ * traffic) evenly over the threads. part is sized by LinearSetPool, so
+ * stepping never allocates. */
+static void LinearPartition(linear_data *data){
+  unsigned n = data->eq_num;
+  unsigned threads = data->pool ? PoolGetThreads(data->pool) : 1;
+  if(!data->row_ptr){
+    return;
+  }
+  double total = data->row_ptr[n] + n;
+  unsigned row = 0;
+  data->part[0] = 0;
+  for(unsigned t = 1; t < threads; t++){
+    double goal = total * t / threads;
+    while(row < n && data->row_ptr[row] + row < goal){
+      row++;
+    }
+    data->part[t] = row;
+  }
+  data->part[threads] = n;
+}
+
+int LinearSetMatrix(linear_data *data, unsigned const row_ptr[],
+                    unsigned const cols[], double const vals[]){
+  if(!data || !row_ptr || row_ptr[0]){
+    return 0;
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    if(row_ptr[i + 1] < row_ptr[i]){
+      return 0;
+    }
+  }
+  unsigned nnz = row_ptr[data->eq_num];
+  if(nnz && (!cols || !vals)){
+    return 0;
+  }
+  for(unsigned j = 0; j < nnz; j++){
+    if(cols[j] >= data->eq_num){
+      return 0;
+    }
+  }
+  unsigned *rp = malloc(sizeof(unsigned)*(data->eq_num + 1));
+  unsigned *cs = malloc(sizeof(unsigned)*(nnz + 1));
+  double *vs = malloc(sizeof(double)*(nnz + 1));
+  if(!rp || !cs || !vs){
+    free(rp);
+    free(cs);
+    free(vs);
+    return 0;
+  }
+  memcpy(rp, row_ptr, sizeof(unsigned)*(data->eq_num + 1));
+  if(nnz){
+    memcpy(cs, cols, sizeof(unsigned)*nnz);
+    memcpy(vs, vals, sizeof(double)*nnz);
+  }
+  free(data->row_ptr);
+  free(data->cols);
+  free(data->vals);
+  data->row_ptr = rp;
+  data->cols = cs;
+  data->vals = vs;
+  LinearPartition(data);
+  return 1;
+}
+
+int LinearSetForce(linear_data *data, LinearForceFunc func){
+  if(!data){
+    return 0;
+  }
+  data->force = func;
+  return 1;
+}
+
+int LinearSetYs0(linear_data *data, double const ys[],
+                 unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->y[i] = ys[i];
+  }
+  return 1;
+}
+
+int LinearSetY0(linear_data *data, double const y, unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0;
+  }
+  data->y[index] = y;
+  return 1;
+}
+
+int LinearSetX(linear_data *data, double const t){
+  if(!data){
+    return 0;
+  }
+  data->x = t;
+  return 1;
+}
+
+int LinearSetStep(linear_data *data, double const step){
+  if(!data){
+    return 0;
+  }
+  data->h = step;
+  return 1;
+}
+
+int LinearSetPool(linear_data *data, pool_data *pool){
+  if(!data){
+    return 0;
+  }
+  unsigned threads = pool ? PoolGetThreads(pool) : 1;
+  unsigned *part = calloc(threads + 1, sizeof(unsigned));
+  if(!part){
+    return 0;
+  }
+  free(data->part);
+  data->part = part;
+  data->pool = pool;
+  LinearPartition(data);
+  return 1;
+}
+
+int LinearCheck(linear_data *data){
+  if(!data || !data->eq_num){
+    fprintf(stderr, "%s\n", "LinearCheck: Incorrect initialization.");
+    return 0;
+  }
+  if(0. == data->h){
+    fprintf(stderr, "%s\n", "LinearCheck: Step must be greater then 0.");
+    return 0;
+  }
+  if(!data->row_ptr){
+    fprintf(stderr, "%s\n", "LinearCheck: Matrix not assigned.");
+    return 0;
+  }
+  return 1;
+}
+
+static void LinearStageTask(unsigned const task, unsigned const thread,
+                            void *arg){
+  linear_data *data = arg;
+  unsigned first = data->part[task];
+  unsigned last = data->part[task + 1];
+  unsigned const *rp = data->row_ptr;
+  unsigned const *cs = data->cols;
+  double const *vs = data->vals;
+  double const *b = data->b;
+  double *y = data->y, *f = data->f;
+  double h05 = data->h * 0.5;
+  double const *z;
+  double *zn;
+  double c;
+  switch(data->stage){
+  case 0:
+    for(unsigned i = first; i < last; i++){
+      double k = b[i];
+      for(unsigned j = rp[i]; j < rp[i + 1]; j++){
+        k += vs[j]*y[cs[j]];
+      }
+      data->zb[i] = y[i] + h05*k;
+      f[i] = k;
+    }
+    break;
+  case 1:
+  case 2:
+    z = data->stage == 1 ? data->zb : data->za;
+    zn = data->stage == 1 ? data->za : data->zb;
+    c = data->stage == 1 ? h05 : data->h;
+    for(unsigned i = first; i < last; i++){
+      double k = b[i];
+      for(unsigned j = rp[i]; j < rp[i + 1]; j++){
+        k += vs[j]*z[cs[j]];
+      }
+      zn[i] = y[i] + c*k;
+      f[i] += 2*k;
+    }
+    break;
+  default:
+    z = data->zb;
+    for(unsigned i = first; i < last; i++){
+      double k = b[i];
+      for(unsigned j = rp[i]; j < rp[i + 1]; j++){
+        k += vs[j]*z[cs[j]];
+      }
+      f[i] = 1./6*(f[i] + k);
+      y[i] += data->h * f[i];
+    }
+  }
+}
+
+static void LinearForce(linear_data *data, double const x){
+  if(data->force){
+    data->force(x, data->b, data->userdata);
+  }
+}
+
+void LinearStep(linear_data *data){
+  static double const c[4] = {0., 0.5, 0.5, 1.};
+  unsigned threads = data->pool ? PoolGetThreads(data->pool) : 1;
+  for(data->stage = 0; data->stage < 4; data->stage++){
+    if(data->stage != 2){
+      LinearForce(data, data->x + c[data->stage]*data->h);
+    }
+    if(data->pool){
+      PoolRunStatic(data->pool, LinearStageTask, threads, data);
+    } else {
+      LinearStageTask(0, 0, data);
+    }
+  }
+  data->x += data->h;
+}
+
+void LinearStepN(linear_data *data, unsigned const n){
+  for(unsigned i = 0; i < n; i++){
+    LinearStep(data);
+  }
+}
+
+double LinearGetY(linear_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->y[num];
+}
+
+double *LinearGetYs(linear_data *data){
+  if(data){
+    return data->y;
+  }
+  return NULL;
+}
+
+double LinearGetX(linear_data *data){
+  if(data){
+    return data->x;
+  }
+  return 0.;
+}
+
+double LinearGetDY(linear_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->f[num];
+}
+
+double *LinearGetDYs(linear_data *data){
+  if(data){
+    return data->f;
+  }
+  return NULL;
+}
+
+int LinearSetUserData(linear_data *data, void *userdata){
+  if(data){
+    data->userdata = userdata;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "stdint.h"
+#include "dist.h"
+
+/* RK5 (the England tableau of rk5.c) over a block row distribution of
+ * the equations. Every stage posts the halo exchange of its input,
+ * evaluates the interior rows that need no halo while messages are in
+ * flight, then finishes the rows next to the slice ends. With a
+ * tolerance the embedded 4th order solution controls the step; the
+ * error norm costs a single MPI_Allreduce per attempt. */
+
+struct dist_data_st{
+  MPI_Comm comm;
+  int left;
+  int right;
+  int rank;
+  int size;
+  unsigned eq_num;
+  unsigned first;
+  unsigned count;
+  unsigned halo;
+  int periodic;
+  double *ybuf;
+  double *wbuf;
+  double *k;
+  double x;
+  double h;
+  double atol;
+  double rtol;
+  DistSysFunc sys;
+  void *userdata;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+#define DIST_MAX_REJECTS 64
+
+static void DistNeighbours(dist_data *data){
+  data->left = data->rank - 1;
+  data->right = data->rank + 1;
+  if(data->periodic){
+    data->left = (data->left + data->size) % data->size;
+    data->right %= data->size;
+  } else {
+    data->left = data->left < 0 ? MPI_PROC_NULL : data->left;
+    data->right = data->right >= data->size ? MPI_PROC_NULL : data->right;
+  }
+}
+
+int DistInitData(dist_data **data, MPI_Comm comm, unsigned const eq_num,
+                 unsigned const halo){
+  *data = calloc(1, sizeof(dist_data));
+  EXIT_IF_NULL(*data);
+  (*data)->comm = comm;
+  MPI_Comm_rank(comm, &(*data)->rank);
+  MPI_Comm_size(comm, &(*data)->size);
+  unsigned r = (unsigned)(*data)->rank, p = (unsigned)(*data)->size;
+  (*data)->eq_num = eq_num;
+  (*data)->count = eq_num/p + (r < eq_num%p);
+  (*data)->first = r*(eq_num/p) + (r < eq_num%p ? r : eq_num%p);
+  (*data)->halo = halo;
+  unsigned n = (*data)->count;
+  (*data)->ybuf = calloc(n + 2*halo, sizeof(double));
+  EXIT_IF_NULL((*data)->ybuf);
+  (*data)->wbuf = calloc(n + 2*halo, sizeof(double));
+  EXIT_IF_NULL((*data)->wbuf);
+  (*data)->k = calloc(6*n + 1, sizeof(double));
+  EXIT_IF_NULL((*data)->k);
+  DistNeighbours(*data);
+  return 1;
+error:
+  if(*data){
+    free((*data)->wbuf);
+    free((*data)->ybuf);
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void DistFreeData(dist_data *data){
+  if(data){
+    free(data->k);
+    free(data->wbuf);
+    free(data->ybuf);
+    free(data);
+  }
+}
+
+unsigned DistGetFirst(dist_data *data){
+  if(data){
+    return data->first;
+  }
+  return 0;
+}
+
+unsigned DistGetCount(dist_data *data){
+  if(data){
+    return data->count;
+  }
+  return 0;
+}
+
+int DistSetYs0(dist_data *data, double const ys[],
+               unsigned const num){
+  if(!data || num != data->count){
+    return 0;
+  }
+  memcpy(data->ybuf + data->halo, ys, sizeof(double)*num);
+  return 1;
+}
+
+int DistSetX(dist_data *data, double const t){
+  if(!data){
+    return 0;
+  }
+  data->x = t;
+  return 1;
+}
+
+int DistSetStep(dist_data *data, double const step){
+  if(!data){
+    return 0;
+  }
+  data->h = step;
+  return 1;
+}
+
+int DistSetTolerance(dist_data *data, double const atol, double const rtol){
+  if(!data || atol < 0. || rtol < 0.){
+    return 0;
+  }
+  data->atol = atol;
+  data->rtol = rtol;
+  return 1;
+}
+
+int DistSetPeriodic(dist_data *data, int const periodic){
+  if(!data){
+    return 0;
+  }
+  data->periodic = periodic;
+  DistNeighbours(data);
+  return 1;
+}
+
+int DistSetSystem(dist_data *data, DistSysFunc func){
+  if(!data){
+    return 0;
+  }
+  data->sys = func;
+  return 1;
+}
+
+int DistCheck(dist_data *data){
+  if(!data || !data->eq_num || !data->count){
+    fprintf(stderr, "%s\n", "DistCheck: Incorrect initialization.");
+    return 0;
+  }
+  if(0. == data->h){
+    fprintf(stderr, "%s\n", "DistCheck: Step must be greater then 0.");
+    return 0;
+  }
+  if(data->count < data->halo){
+    fprintf(stderr, "%s\n", "DistCheck: Local slice is smaller then the halo.");
+    return 0;
+  }
+  if(!data->sys){
+    fprintf(stderr, "%s\n", "DistCheck: Right side function not assigned.");
+    return 0;
+  }
+  return 1;
+}
+
+/* buf has halo cells on both sides; y = buf + halo. */
+static void DistEval(dist_data *data, double const x, double *buf,
+                     double *k){
+  unsigned const n = data->count;
+  unsigned const g = data->halo;
+  double *y = buf + g;
+  MPI_Request req[4];
+  MPI_Irecv(buf, g, MPI_DOUBLE, data->left, 1, data->comm, &req[0]);
+  MPI_Irecv(y + n, g, MPI_DOUBLE, data->right, 0, data->comm, &req[1]);
+  MPI_Isend(y, g, MPI_DOUBLE, data->left, 0, data->comm, &req[2]);
+  MPI_Isend(y + n - g, g, MPI_DOUBLE, data->right, 1, data->comm, &req[3]);
+  if(n > 2*g){
+    data->sys(x, y, k, g, n - g, data->userdata);
+  }
+  MPI_Waitall(4, req, MPI_STATUSES_IGNORE);
+  unsigned lo = g < n ? g : n;
+  unsigned hi = n > 2*g ? n - g : lo;
+  data->sys(x, y, k, 0, lo, data->userdata);
+  if(hi < n){
+    data->sys(x, y, k, hi, n, data->userdata);
+  }
+}
+
+static const double RK5_CONST[] = {1./24., 5./48., 27./56., 125./336.};
+static const double RK5_ERR[] = {-1./8., -2./3., -1./16., 27./56., 125./336.};
+
+/* Stage sequence of RK5Step; returns the scaled error norm or 0. */
+static double DistTry(dist_data *data, double *ynew){
+  unsigned const n = data->count;
+  double const h = data->h;
+  double const x = data->x;
+  double *y = data->ybuf + data->halo;
+  double *w = data->wbuf + data->halo;
+  double *k1 = data->k, *k2 = k1 + n, *k3 = k2 + n,
+         *k4 = k3 + n, *k5 = k4 + n, *k6 = k5 + n;
+  DistEval(data, x, data->ybuf, k1);
+  for(unsigned i = 0; i < n; i++){
+    w[i] = y[i] + 0.5*h*k1[i];
+  }
+  DistEval(data, x + 0.5*h, data->wbuf, k2);
+  for(unsigned i = 0; i < n; i++){
+    w[i] = y[i] + 0.25*h*(k1[i] + k2[i]);
+  }
+  DistEval(data, x + 0.5*h, data->wbuf, k3);
+  for(unsigned i = 0; i < n; i++){
+    w[i] = y[i] + h*(2.*k3[i] - k2[i]);
+  }
+  DistEval(data, x + h, data->wbuf, k4);
+  for(unsigned i = 0; i < n; i++){
+    w[i] = y[i] + 1./27.*h*(7.*k1[i] + 10.*k2[i] + k4[i]);
+  }
+  DistEval(data, x + 2./3.*h, data->wbuf, k5);
+  for(unsigned i = 0; i < n; i++){
+    w[i] = y[i] + 1./625.*h*(28.*k1[i] - 125.*k2[i] + 546.*k3[i] +
+                             54.*k4[i] - 378.*k5[i]);
+  }
+  DistEval(data, x + 1./5.*h, data->wbuf, k6);
+  double local = 0., global = 0.;
+  for(unsigned i = 0; i < n; i++){
+    ynew[i] = y[i] + h*(RK5_CONST[0]*k1[i] + RK5_CONST[1]*k4[i] +
+                        RK5_CONST[2]*k5[i] + RK5_CONST[3]*k6[i]);
+    if(data->atol > 0. || data->rtol > 0.){
+      double e = h*(RK5_ERR[0]*k1[i] + RK5_ERR[1]*k3[i] + RK5_ERR[2]*k4[i] +
+                    RK5_ERR[3]*k5[i] + RK5_ERR[4]*k6[i]);
+      e /= data->atol + data->rtol*fmax(fabs(y[i]), fabs(ynew[i]));
+      local += e*e;
+    }
+  }
+  if(data->atol > 0. || data->rtol > 0.){
+    MPI_Allreduce(&local, &global, 1, MPI_DOUBLE, MPI_SUM, data->comm);
+  }
+  return sqrt(global/data->eq_num);
+}
+
+/* Bitwise, since -ffast-math lets the compiler assume isfinite(). */
+static int DistFinite(double const v){
+  uint64_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  return (bits >> 52 & 0x7FF) != 0x7FF;
+}
+
+/* err is the same on every rank after the Allreduce, so all ranks take
+ * the same branches and give up together. */
+int DistStep(dist_data *data){
+  double ynew[data->count];
+  double const h0 = data->h;
+  int adaptive = data->atol > 0. || data->rtol > 0.;
+  for(unsigned rejects = 0; rejects < DIST_MAX_REJECTS; rejects++){
+    double err = DistTry(data, ynew);
+    int finite = DistFinite(err);
+    double fac = !finite ? 0.2 : (err > 0. ? 0.9*pow(err, -0.2) : 5.);
+    fac = fac < 0.2 ? 0.2 : (fac > 5. ? 5. : fac);
+    if(!adaptive || (finite && err <= 1.)){
+      memcpy(data->ybuf + data->halo, ynew, sizeof(double)*data->count);
+      data->x += data->h;
+      if(adaptive){
+        data->h *= fac;
+      }
+      return 1;
+    }
+    data->h *= fac;
+  }
+  data->h = h0;
+  return 0;
+}
+
+double *DistGetYs(dist_data *data){
+  if(data){
+    return data->ybuf + data->halo;
+  }
+  return NULL;
+}
+
+double DistGetX(dist_data *data){
+  if(data){
+    return data->x;
+  }
+  return 0.;
+}
+
+double DistGetStep(dist_data *data){
+  if(data){
+    return data->h;
+  }
+  return 0.;
+}
+
+int DistSetUserData(dist_data *data, void *userdata){
+  if(data){
+    data->userdata = userdata;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <math.h>
+#include "dist.h"
+
+#define EXIT_IF_0(X) if(!(X)) goto error
+
+#define POINTS 64
+
+#define PI 3.14159265358979323846
+
+struct heat_data{
+  double dx2; //squared grid step
+};
+
+void RightSideHeat(double const x, double const *y, double *dy,
+                   unsigned const first, unsigned const last,
+                   void *userdata){
+  struct heat_data *data = userdata;
+  for(int i = first; i < (int)last; i++){
+    dy[i] = (y[i - 1] - 2.*y[i] + y[i + 1])/data->dx2;
+  }
+}
+
+void RightSideNaN(double const x, double const *y, double *dy,
+                  unsigned const first, unsigned const last,
+                  void *userdata){
+  for(unsigned i = first; i < last; i++){
+    dy[i] = NAN;
+  }
+}
+
+int TestDist(void){
+  dist_data *data;
+  double const dx = 1./POINTS;
+  struct heat_data udata = {dx*dx};
+  EXIT_IF_0(DistInitData(&data, MPI_COMM_WORLD, POINTS, 1));
+  unsigned first = DistGetFirst(data);
+  unsigned count = DistGetCount(data);
+  double vals[POINTS];
+  for(unsigned i = 0; i < count; i++){
+    vals[i] = sin(2.*PI*(first + i)*dx);
+  }
+  EXIT_IF_0(DistSetYs0(data, vals, count));
+  EXIT_IF_0(DistSetX(data, 0.));
+  EXIT_IF_0(DistSetPeriodic(data, 1));
+  EXIT_IF_0(DistSetSystem(data, RightSideHeat));
+  EXIT_IF_0(DistSetUserData(data, &udata));
+  EXIT_IF_0(DistSetStep(data, 1.E-5));
+  EXIT_IF_0(DistSetTolerance(data, 1.E-9, 1.E-9));
+  EXIT_IF_0(DistCheck(data));
+  unsigned steps = 0;
+  while(DistGetX(data) < 0.01){
+    EXIT_IF_0(DistStep(data));
+    steps++;
+  }
+  double t = DistGetX(data);
+  double lambda = -4.*pow(sin(PI*dx), 2)/udata.dx2;
+  double err = 0., gerr;
+  for(unsigned i = 0; i < count; i++){
+    double e = fabs(DistGetYs(data)[i] -
+                    exp(lambda*t)*sin(2.*PI*(first + i)*dx));
+    err = e > err ? e : err;
+  }
+  MPI_Allreduce(&err, &gerr, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if(!rank){
+    printf("%.12g\t%u\t%.3g\n", t, steps, gerr);
+  }
+  EXIT_IF_0(gerr < 1.E-7);
+  /* NaN on one rank only: every rank must fail the step, not hang */
+  EXIT_IF_0(DistSetSystem(data, rank ? RightSideHeat : RightSideNaN));
+  EXIT_IF_0(!DistStep(data));
+  EXIT_IF_0(DistGetX(data) == t);
+  DistFreeData(data);
+  return 1;
+error:
+  return 0;
+}
+
+int main(int argc, char *argv[]){
+  MPI_Init(&argc, &argv);
+  int res = TestDist();
+  MPI_Finalize();
+  return !res;
+}
@@ -0,0 +1,200 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "pthread.h"
+#include "sched.h"
+#include "time.h"
+#include "observer.h"
+
+/* Single producer/single consumer ring of (x, y[eq_num]) records. The
+ * stepping thread only copies a record and publishes the new head; the
+ * consumer thread formats and writes records in the layout of test.c.
+ * Head and tail live on separate cache lines. */
+
+#define CACHE_LINE 64
+
+struct observer_data_st{
+  unsigned eq_num;
+  unsigned long mask;
+  double *ring;
+  FILE *out;
+  enum ObserverPolicy policy;
+  unsigned long decimation;
+  unsigned long counter;
+  unsigned long dropped;
+  int running;
+  pthread_t consumer;
+  char pad0[CACHE_LINE];
+  unsigned long head;
+  char pad1[CACHE_LINE - sizeof(unsigned long)];
+  unsigned long tail;
+  char pad2[CACHE_LINE - sizeof(unsigned long)];
+  int stop;
+  unsigned long written;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+int ObserverInitData(obs_data **data, unsigned const eq_num,
+                     unsigned const capacity){
+  unsigned long cap = 2;
+  while(cap < capacity){
+    cap <<= 1;
+  }
+  *data = calloc(1, sizeof(obs_data));
+  EXIT_IF_NULL(*data);
+  (*data)->eq_num = eq_num;
+  (*data)->mask = cap - 1;
+  (*data)->ring = calloc(cap*(eq_num + 1), sizeof(double));
+  EXIT_IF_NULL((*data)->ring);
+  (*data)->out = stdout;
+  (*data)->policy = OBSERVER_BLOCK;
+  (*data)->decimation = 1;
+  return 1;
+error:
+  if(*data){
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void ObserverFreeData(obs_data *data){
+  if(data){
+    ObserverStop(data);
+    free(data->ring);
+    free(data);
+  }
+}
+
+int ObserverSetPolicy(obs_data *data, enum ObserverPolicy const policy){
+  if(!data || data->running ||
+     (policy != OBSERVER_BLOCK && policy != OBSERVER_DROP &&
+      policy != OBSERVER_DECIMATE)){
+    return 0;
+  }
+  data->policy = policy;
+  return 1;
+}
+
+int ObserverSetOutput(obs_data *data, FILE *out){
+  if(!data || !out || data->running){
+    return 0;
+  }
+  data->out = out;
+  return 1;
+}
+
+static void ObserverWrite(obs_data *data, double const *rec){
+  fprintf(data->out, "%.12g", rec[0]);
+  for(unsigned i = 1; i <= data->eq_num; i++){
+    fprintf(data->out, "\t%.12g", rec[i]);
+  }
+  fputc('\n', data->out);
+}
+
+static void *ObserverConsumer(void *arg){
+  obs_data *data = arg;
+  struct timespec idle = {0, 50000};
+  unsigned long tail = __atomic_load_n(&data->tail, __ATOMIC_RELAXED);
+  for(;;){
+    unsigned long head = __atomic_load_n(&data->head, __ATOMIC_ACQUIRE);
+    if(tail == head){
+      if(__atomic_load_n(&data->stop, __ATOMIC_ACQUIRE)){
+        if(tail == __atomic_load_n(&data->head, __ATOMIC_ACQUIRE)){
+          break;
+        }
+        continue;
+      }
+      nanosleep(&idle, NULL);
+      continue;
+    }
+    for(; tail != head; tail++){
+      ObserverWrite(data, &data->ring[(tail & data->mask)*(data->eq_num + 1)]);
+      data->written++;
+      __atomic_store_n(&data->tail, tail + 1, __ATOMIC_RELEASE);
+    }
+  }
+  fflush(data->out);
+  return NULL;
+}
+
+int ObserverStart(obs_data *data){
+  if(!data || data->running){
+    return 0;
+  }
+  data->stop = 0;
+  data->head = data->tail = 0;
+  data->counter = 0;
+  data->decimation = 1;
+  data->written = 0;
+  data->dropped = 0;
+  if(pthread_create(&data->consumer, NULL, ObserverConsumer, data)){
+    return 0;
+  }
+  data->running = 1;
+  return 1;
+}
+
+int ObserverPush(obs_data *data, double const x, double const *ys){
+  if(!data || !ys || !data->running){
+    return -1;
+  }
+  unsigned long cap = data->mask + 1;
+  unsigned long head = data->head;
+  unsigned long tail = __atomic_load_n(&data->tail, __ATOMIC_ACQUIRE);
+  if(OBSERVER_DECIMATE == data->policy){
+    if(data->decimation > 1 && head - tail < cap/4){
+      data->decimation >>= 1;
+    }
+    if(data->counter++ % data->decimation){
+      return 0;
+    }
+  }
+  if(head - tail == cap){
+    switch(data->policy){
+    case OBSERVER_BLOCK:
+      while(head - __atomic_load_n(&data->tail, __ATOMIC_ACQUIRE) == cap){
+        sched_yield();
+      }
+      break;
+    case OBSERVER_DECIMATE:
+      data->decimation <<= 1;
+      data->dropped++;
+      return 0;
+    default:
+      data->dropped++;
+      return 0;
+    }
+  }
+  double *rec = &data->ring[(head & data->mask)*(data->eq_num + 1)];
+  rec[0] = x;
+  memcpy(rec + 1, ys, sizeof(double)*data->eq_num);
+  __atomic_store_n(&data->head, head + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+int ObserverStop(obs_data *data){
+  if(!data || !data->running){
+    return 0;
+  }
+  __atomic_store_n(&data->stop, 1, __ATOMIC_RELEASE);
+  pthread_join(data->consumer, NULL);
+  data->running = 0;
+  return 1;
+}
+
+unsigned long ObserverGetWritten(obs_data *data){
+  if(data && !data->running){
+    return data->written;
+  }
+  return 0;
+}
+
+unsigned long ObserverGetDropped(obs_data *data){
+  if(data){
+    return data->dropped;
+  }
+  return 0;
+}
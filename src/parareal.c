@@ -0,0 +1,420 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "time.h"
+#include "parareal.h"
+#include "pool.h"
+#include "rk4.h"
+#include "rk5.h"
+#include "adams5.h"
+
+struct parareal_data_st{
+  unsigned eq_num;
+  unsigned slices;
+  double *y0;
+  double *u;
+  double *g;
+  double *fine;
+  double *fine_time;
+  double x;
+  double x_end;
+  double h_coarse;
+  double h_fine;
+  enum PararealFine method;
+  double tol;
+  unsigned max_iter;
+  unsigned threads;
+  unsigned iterations;
+  int converged;
+  double speedup;
+  PararealRSFunc *funcs;
+  void *userdata;
+};
+
+struct parareal_job_st{
+  pr_data *data;
+  unsigned first;
+  rk5_data **rk5;
+  a5_data **a5;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+int PararealInitData(pr_data **data, unsigned const eq_num,
+                     unsigned const slices){
+  *data = calloc(1, sizeof(pr_data));
+  EXIT_IF_NULL(*data);
+  (*data)->eq_num = eq_num;
+  (*data)->slices = slices;
+  (*data)->y0 = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->y0);
+  (*data)->u = calloc(eq_num*(slices + 1), sizeof(double));
+  EXIT_IF_NULL((*data)->u);
+  (*data)->g = calloc(eq_num*(slices + 1), sizeof(double));
+  EXIT_IF_NULL((*data)->g);
+  (*data)->fine = calloc(eq_num*(slices + 1), sizeof(double));
+  EXIT_IF_NULL((*data)->fine);
+  (*data)->fine_time = calloc(slices + 1, sizeof(double));
+  EXIT_IF_NULL((*data)->fine_time);
+  (*data)->funcs = calloc(eq_num, sizeof(PararealRSFunc));
+  EXIT_IF_NULL((*data)->funcs);
+  (*data)->method = PARAREAL_FINE_RK5;
+  (*data)->tol = 1.E-8;
+  (*data)->max_iter = slices;
+  (*data)->threads = 1;
+  return 1;
+error:
+  if(*data){
+    free((*data)->fine_time);
+    free((*data)->fine);
+    free((*data)->g);
+    free((*data)->u);
+    free((*data)->y0);
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void PararealFreeData(pr_data *data){
+  if(data){
+    free(data->funcs);
+    free(data->fine_time);
+    free(data->fine);
+    free(data->g);
+    free(data->u);
+    free(data->y0);
+    free(data);
+  }
+}
+
+int PararealSetYs0(pr_data *data, double const ys[],
+                   unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->y0[i] = ys[i];
+  }
+  return 1;
+}
+
+int PararealSetY0(pr_data *data, double const y, unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0;
+  }
+  data->y0[index] = y;
+  return 1;
+}
+
+int PararealSetX(pr_data *data, double const t){
+  if(!data){
+    return 0;
+  }
+  data->x = t;
+  return 1;
+}
+
+int PararealSetXEnd(pr_data *data, double const t){
+  if(!data){
+    return 0;
+  }
+  data->x_end = t;
+  return 1;
+}
+
+int PararealSetCoarseStep(pr_data *data, double const step){
+  if(!data){
+    return 0;
+  }
+  data->h_coarse = step;
+  return 1;
+}
+
+int PararealSetFineStep(pr_data *data, double const step){
+  if(!data){
+    return 0;
+  }
+  data->h_fine = step;
+  return 1;
+}
+
+int PararealSetFineMethod(pr_data *data, enum PararealFine const method){
+  if(!data ||
+     (method != PARAREAL_FINE_RK5 && method != PARAREAL_FINE_ADAMS5)){
+    return 0;
+  }
+  data->method = method;
+  return 1;
+}
+
+int PararealSetEquation(pr_data *data, PararealRSFunc func,
+                        unsigned const index){
+  if(!data || index >= data->eq_num){
+      return 0;
+    }
+  data->funcs[index] = func;
+  return 1;
+}
+
+int PararealSetEquations(pr_data *data, PararealRSFunc func[],
+                         unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->funcs[i] = func[i];
+  }
+  return 1;
+}
+
+int PararealSetTolerance(pr_data *data, double const tol){
+  if(!data || tol < 0.){
+    return 0;
+  }
+  data->tol = tol;
+  return 1;
+}
+
+int PararealSetMaxIterations(pr_data *data, unsigned const iters){
+  if(!data){
+    return 0;
+  }
+  data->max_iter = iters;
+  return 1;
+}
+
+int PararealSetThreads(pr_data *data, unsigned const threads){
+  if(!data || !threads){
+    return 0;
+  }
+  data->threads = threads;
+  return 1;
+}
+
+int PararealCheck(pr_data *data){
+  if(!data || !data->eq_num || !data->slices){
+    fprintf(stderr, "%s\n", "PararealCheck: Incorrect initialization.");
+    return 0;
+  }
+  if(data->h_coarse <= 0. || data->h_fine <= 0.){
+    fprintf(stderr, "%s\n", "PararealCheck: Steps must be greater then 0.");
+    return 0;
+  }
+  if(data->x_end <= data->x){
+    fprintf(stderr, "%s\n", "PararealCheck: End point must be greater then start point.");
+    return 0;
+  }
+  for(unsigned i = 0; i< data->eq_num; i++){
+    if(!data->funcs[i]){
+      fprintf(stderr, "%s%d%s\n", "PararealCheck: Right side functions for parameter number ", i, " not assigned.");
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static double PararealClock(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1.E-9*ts.tv_nsec;
+}
+
+static unsigned PararealStepsNum(double const span, double const h){
+  double n = ceil(span/h - 1.E-9);
+  return n < 1. ? 1 : (unsigned)n;
+}
+
+static double PararealSliceX(pr_data *data, unsigned const slice){
+  return data->x + (data->x_end - data->x)*slice/data->slices;
+}
+
+static void PararealCoarse(pr_data *data, rk_data *rk, unsigned const slice,
+                           double const *y0, double *y1){
+  double span = PararealSliceX(data, slice + 1) - PararealSliceX(data, slice);
+  unsigned n = PararealStepsNum(span, data->h_coarse);
+  RK4SetYs0(rk, y0, data->eq_num);
+  RK4SetX(rk, PararealSliceX(data, slice));
+  RK4SetStep(rk, span/n);
+  for(unsigned i = 0; i < n; i++){
+    RK4Step(rk);
+  }
+  memcpy(y1, RK4GetYs(rk), sizeof(double)*data->eq_num);
+}
+
+static void PararealFineTask(unsigned const task, unsigned const thread,
+                             void *arg){
+  struct parareal_job_st *job = arg;
+  pr_data *data = job->data;
+  unsigned slice = job->first + task;
+  double const *y0 = &data->u[slice*data->eq_num];
+  double *y1 = &data->fine[(slice + 1)*data->eq_num];
+  double x0 = PararealSliceX(data, slice);
+  double span = PararealSliceX(data, slice + 1) - x0;
+  unsigned n = PararealStepsNum(span, data->h_fine);
+  double start = PararealClock();
+  if(PARAREAL_FINE_RK5 == data->method){
+    rk5_data *rk = job->rk5[thread];
+    RK5SetYs0(rk, y0, data->eq_num);
+    RK5SetX(rk, x0);
+    RK5SetStep(rk, span/n);
+    for(unsigned i = 0; i < n; i++){
+      RK5Step(rk);
+    }
+    memcpy(y1, RK5GetYs(rk), sizeof(double)*data->eq_num);
+  } else {
+    a5_data *a5 = job->a5[thread];
+    Adams5SetYs0(a5, y0, data->eq_num);
+    Adams5SetX(a5, x0);
+    Adams5SetStep(a5, span/n);
+    for(unsigned i = 0; i < n; i++){
+      Adams5Step(a5);
+    }
+    memcpy(y1, Adams5GetYs(a5), sizeof(double)*data->eq_num);
+  }
+  data->fine_time[slice + 1] = PararealClock() - start;
+}
+
+int PararealSolve(pr_data *data){
+  unsigned const n = data->eq_num;
+  unsigned const threads = data->threads;
+  double start = PararealClock();
+  double serial = 0.;
+  double *gnew = NULL;
+  pool_data *pool = NULL;
+  rk_data *rk = NULL;
+  struct parareal_job_st job = {data, 0, NULL, NULL};
+  int res = 0;
+  gnew = calloc(n, sizeof(double));
+  EXIT_IF_NULL(gnew);
+  job.rk5 = calloc(threads, sizeof(rk5_data *));
+  EXIT_IF_NULL(job.rk5);
+  job.a5 = calloc(threads, sizeof(a5_data *));
+  EXIT_IF_NULL(job.a5);
+  if(!RK4InitData(&rk, n) || !RK4SetEquations(rk, data->funcs, n) ||
+     !RK4SetUserData(rk, data->userdata) || !PoolInitData(&pool, threads)){
+    goto error;
+  }
+  for(unsigned t = 0; t < threads; t++){
+    if(PARAREAL_FINE_RK5 == data->method){
+      if(!RK5InitData(&job.rk5[t], n) ||
+         !RK5SetEquations(job.rk5[t], data->funcs, n) ||
+         !RK5SetUserData(job.rk5[t], data->userdata)){
+        goto error;
+      }
+    } else {
+      if(!Adams5InitData(&job.a5[t], n) ||
+         !Adams5SetEquations(job.a5[t], data->funcs, n) ||
+         !Adams5SetUserData(job.a5[t], data->userdata)){
+        goto error;
+      }
+    }
+  }
+  memcpy(data->u, data->y0, sizeof(double)*n);
+  for(unsigned s = 0; s < data->slices; s++){
+    PararealCoarse(data, rk, s, &data->u[s*n], &data->g[(s + 1)*n]);
+    memcpy(&data->u[(s + 1)*n], &data->g[(s + 1)*n], sizeof(double)*n);
+  }
+  data->iterations = 0;
+  data->converged = 0;
+  while(!data->converged && data->iterations < data->max_iter){
+    double diff = 0.;
+    job.first = data->iterations;
+    PoolRun(pool, PararealFineTask, data->slices - job.first, &job);
+    if(!data->iterations){
+      for(unsigned s = 1; s <= data->slices; s++){
+        serial += data->fine_time[s];
+      }
+    }
+    for(unsigned s = job.first; s < data->slices; s++){
+      double *u = &data->u[(s + 1)*n];
+      double *g = &data->g[(s + 1)*n];
+      double *f = &data->fine[(s + 1)*n];
+      PararealCoarse(data, rk, s, &data->u[s*n], gnew);
+      for(unsigned i = 0; i < n; i++){
+        double un = gnew[i] + f[i] - g[i];
+        double d = fabs(un - u[i])/(1. + fabs(un));
+        diff = d > diff ? d : diff;
+        u[i] = un;
+        g[i] = gnew[i];
+      }
+    }
+    data->iterations++;
+    data->converged = diff <= data->tol ||
+                      data->iterations == data->slices;
+  }
+  data->speedup = serial/(PararealClock() - start);
+  res = 1;
+error:
+  for(unsigned t = 0; job.rk5 && t < threads; t++){
+    RK5FreeData(job.rk5[t]);
+  }
+  for(unsigned t = 0; job.a5 && t < threads; t++){
+    Adams5FreeData(job.a5[t]);
+  }
+  free(job.a5);
+  free(job.rk5);
+  PoolFreeData(pool);
+  RK4FreeData(rk);
+  free(gnew);
+  return res;
+}
+
+double PararealGetY(pr_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->u[data->slices*data->eq_num + num];
+}
+
+double *PararealGetYs(pr_data *data){
+  if(data){
+    return &data->u[data->slices*data->eq_num];
+  }
+  return NULL;
+}
+
+double *PararealGetSliceYs(pr_data *data, unsigned const slice){
+  if(!data || slice > data->slices){
+    return NULL;
+  }
+  return &data->u[slice*data->eq_num];
+}
+
+double PararealGetX(pr_data *data){
+  if(data){
+    return data->x_end;
+  }
+  return 0.;
+}
+
+unsigned PararealGetIterations(pr_data *data){
+  if(data){
+    return data->iterations;
+  }
+  return 0;
+}
+
+int PararealIsConverged(pr_data *data){
+  if(data){
+    return data->converged;
+  }
+  return 0;
+}
+
+double PararealGetSpeedup(pr_data *data){
+  if(data){
+    return data->speedup;
+  }
+  return 0.;
+}
+
+int PararealSetUserData(pr_data *data, void *userdata){
+  if(data){
+    data->userdata = userdata;
+    return 1;
+  }
+  return 0;
+}
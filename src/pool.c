@@ -0,0 +1,206 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include "stdlib.h"
+#include "pthread.h"
+#include "sched.h"
+#include "pool.h"
+
+/* Fixed set of worker threads executing PoolRun jobs. The calling thread
+ * takes part in every job as thread 0, so a pool of one thread starts no
+ * workers at all. PoolRun hands tasks out one by one from a shared
+ * counter; PoolRunStatic runs task t on thread t % threads, so data a
+ * task first touched stays local to the (pinned) thread using it. */
+
+struct pool_worker_st{
+  pool_data *pool;
+  unsigned id;
+};
+
+struct pool_data_st{
+  unsigned threads;
+  pthread_t *workers;
+  struct pool_worker_st *args;
+  unsigned started;
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  unsigned long generation;
+  int stop;
+  PoolTaskFunc func;
+  void *arg;
+  unsigned tasks;
+  unsigned next;
+  unsigned active;
+  int fixed;
+#ifdef __linux__
+  /* mask of the pinned caller before the first PoolSetAffinity */
+  int pinned;
+  pthread_t owner;
+  cpu_set_t owner_mask;
+#endif
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+/* Must be called with the pool lock held. */
+static void PoolRunTasks(pool_data *data, unsigned const thread){
+  if(data->fixed){
+    pthread_mutex_unlock(&data->lock);
+    for(unsigned task = thread; task < data->tasks; task += data->threads){
+      data->func(task, thread, data->arg);
+    }
+    pthread_mutex_lock(&data->lock);
+    return;
+  }
+  while(data->next < data->tasks){
+    unsigned task = data->next++;
+    pthread_mutex_unlock(&data->lock);
+    data->func(task, thread, data->arg);
+    pthread_mutex_lock(&data->lock);
+  }
+}
+
+static void *PoolWorker(void *arg){
+  struct pool_worker_st *worker = arg;
+  pool_data *data = worker->pool;
+  unsigned long seen = 0;
+  pthread_mutex_lock(&data->lock);
+  for(;;){
+    while(!data->stop && data->generation == seen){
+      pthread_cond_wait(&data->start, &data->lock);
+    }
+    if(data->stop){
+      break;
+    }
+    seen = data->generation;
+    PoolRunTasks(data, worker->id);
+    if(0 == --data->active){
+      pthread_cond_signal(&data->done);
+    }
+  }
+  pthread_mutex_unlock(&data->lock);
+  return NULL;
+}
+
+int PoolInitData(pool_data **data, unsigned const threads){
+  *data = calloc(1, sizeof(pool_data));
+  EXIT_IF_NULL(*data);
+  (*data)->threads = threads ? threads : 1;
+  (*data)->workers = calloc((*data)->threads, sizeof(pthread_t));
+  EXIT_IF_NULL((*data)->workers);
+  (*data)->args = calloc((*data)->threads, sizeof(struct pool_worker_st));
+  EXIT_IF_NULL((*data)->args);
+  pthread_mutex_init(&(*data)->lock, NULL);
+  pthread_cond_init(&(*data)->start, NULL);
+  pthread_cond_init(&(*data)->done, NULL);
+  for(unsigned i = 1; i < (*data)->threads; i++){
+    (*data)->args[i].pool = *data;
+    (*data)->args[i].id = i;
+    if(pthread_create(&(*data)->workers[i], NULL, PoolWorker,
+                      &(*data)->args[i])){
+      PoolFreeData(*data);
+      *data = NULL;
+      return 0;
+    }
+    (*data)->started = i;
+  }
+  return 1;
+error:
+  if(*data){
+    free((*data)->workers);
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void PoolFreeData(pool_data *data){
+  if(data){
+    pthread_mutex_lock(&data->lock);
+    data->stop = 1;
+    pthread_cond_broadcast(&data->start);
+    pthread_mutex_unlock(&data->lock);
+    for(unsigned i = 1; i <= data->started; i++){
+      pthread_join(data->workers[i], NULL);
+    }
+#ifdef __linux__
+    if(data->pinned){
+      pthread_setaffinity_np(data->owner, sizeof(data->owner_mask),
+                             &data->owner_mask);
+    }
+#endif
+    pthread_cond_destroy(&data->done);
+    pthread_cond_destroy(&data->start);
+    pthread_mutex_destroy(&data->lock);
+    free(data->args);
+    free(data->workers);
+    free(data);
+  }
+}
+
+static int PoolStart(pool_data *data, PoolTaskFunc func,
+                     unsigned const tasks, void *arg, int const fixed){
+  if(!data || !func){
+    return 0;
+  }
+  pthread_mutex_lock(&data->lock);
+  data->fixed = fixed;
+  data->func = func;
+  data->arg = arg;
+  data->tasks = tasks;
+  data->next = 0;
+  data->active = data->threads - 1;
+  data->generation++;
+  pthread_cond_broadcast(&data->start);
+  PoolRunTasks(data, 0);
+  while(data->active){
+    pthread_cond_wait(&data->done, &data->lock);
+  }
+  pthread_mutex_unlock(&data->lock);
+  return 1;
+}
+
+int PoolRun(pool_data *data, PoolTaskFunc func, unsigned const tasks,
+            void *arg){
+  return PoolStart(data, func, tasks, arg, 0);
+}
+
+int PoolRunStatic(pool_data *data, PoolTaskFunc func, unsigned const tasks,
+                  void *arg){
+  return PoolStart(data, func, tasks, arg, 1);
+}
+
+int PoolSetAffinity(pool_data *data, int const cpus[], unsigned const num){
+  if(!data || !cpus || !num){
+    return 0;
+  }
+#ifdef __linux__
+  if(!data->pinned){
+    data->owner = pthread_self();
+    if(pthread_getaffinity_np(data->owner, sizeof(data->owner_mask),
+                              &data->owner_mask)){
+      return 0;
+    }
+    data->pinned = 1;
+  }
+  for(unsigned i = 0; i < data->threads; i++){
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[i % num], &set);
+    pthread_t thread = i ? data->workers[i] : pthread_self();
+    if(pthread_setaffinity_np(thread, sizeof(set), &set)){
+      return 0;
+    }
+  }
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+unsigned PoolGetThreads(pool_data *data){
+  if(data){
+    return data->threads;
+  }
+  return 0;
+}
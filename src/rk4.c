@@ -1,5 +1,7 @@
+#define _POSIX_C_SOURCE 200112L
 #include <stdio.h>
 #include "stdlib.h"
+#include "string.h"
 #include "rk4.h"
 
 struct rk4_data_st{
@@ -9,6 +11,14 @@ struct rk4_data_st{
   double x;
   double h;
   RK4RSFunc *funcs;
+  RK4SysFunc sys;
+  RK4RangeFunc range;
+  pool_data *pool;
+  unsigned *part;
+  double *work;
+  unsigned stage;
+  unsigned char *rate;
+  unsigned substeps;
   void *userdata;
 };
 
@@ -24,9 +34,13 @@ int RK4InitData(rk_data **data, unsigned const eq_num){
   EXIT_IF_NULL((*data)->funcs);
   (*data)->f = calloc(eq_num, sizeof(double));
   EXIT_IF_NULL((*data)->f);
+  (*data)->rate = calloc(eq_num, sizeof(unsigned char));
+  EXIT_IF_NULL((*data)->rate);
+  (*data)->substeps = 1;
   return 1;
 error:
   if(*data){
+    free((*data)->f);
     free((*data)->funcs);
     free((*data)->y);
     free(*data);
@@ -37,6 +51,9 @@ error:
 
 void RK4FreeData(rk_data *data){
   if(data){
+    free(data->part);
+    free(data->work);
+    free(data->rate);
     free(data->f);
     free(data->funcs);
     free(data->y);
@@ -99,6 +116,114 @@ int RK4SetEquations(rk_data *data, RK4RSFunc func[],
   return 1;
 }
 
+int RK4SetSystem(rk_data *data, RK4SysFunc func){
+  if(!data){
+    return 0;
+  }
+  data->sys = func;
+  return 1;
+}
+
+int RK4SetRangeSystem(rk_data *data, RK4RangeFunc func){
+  if(!data){
+    return 0;
+  }
+  data->range = func;
+  return 1;
+}
+
+/* Page sized partition bounds keep each page with a single thread. */
+#define RK4_PAGE 4096
+#define RK4_PAGE_DOUBLES (RK4_PAGE / sizeof(double))
+
+static size_t RK4Stride(unsigned const eq_num){
+  return (eq_num + RK4_PAGE_DOUBLES - 1) / RK4_PAGE_DOUBLES * RK4_PAGE_DOUBLES;
+}
+
+struct rk4_touch_st{
+  rk_data *data;
+  double *y;
+  double *f;
+  double *work;
+};
+
+static void RK4TouchTask(unsigned const task, unsigned const thread,
+                         void *arg){
+  struct rk4_touch_st *touch = arg;
+  rk_data *data = touch->data;
+  size_t stride = RK4Stride(data->eq_num);
+  for(unsigned i = data->part[task]; i < data->part[task + 1]; i++){
+    touch->y[i] = data->y[i];
+    touch->f[i] = data->f[i];
+    for(unsigned j = 0; j < 6; j++){
+      touch->work[j*stride + i] = 0.;
+    }
+  }
+}
+
+int RK4SetPool(rk_data *data, pool_data *pool){
+  if(!data){
+    return 0;
+  }
+  if(!pool){
+    free(data->part);
+    data->part = NULL;
+    data->pool = NULL;
+    return 1;
+  }
+  unsigned threads = PoolGetThreads(pool);
+  size_t stride = RK4Stride(data->eq_num);
+  struct rk4_touch_st touch = {data, NULL, NULL, NULL};
+  unsigned *part = malloc(sizeof(unsigned)*(threads + 1));
+  EXIT_IF_NULL(part);
+  if(posix_memalign((void **)&touch.y, RK4_PAGE, sizeof(double)*stride) ||
+     posix_memalign((void **)&touch.f, RK4_PAGE, sizeof(double)*stride) ||
+     posix_memalign((void **)&touch.work, RK4_PAGE,
+                    6*sizeof(double)*stride)){
+    goto error;
+  }
+  for(unsigned t = 0; t <= threads; t++){
+    size_t first = (size_t)data->eq_num * t / threads;
+    first = (first + RK4_PAGE_DOUBLES - 1) / RK4_PAGE_DOUBLES * RK4_PAGE_DOUBLES;
+    part[t] = first < data->eq_num ? first : data->eq_num;
+  }
+  free(data->part);
+  data->part = part;
+  PoolRunStatic(pool, RK4TouchTask, threads, &touch);
+  free(data->y);
+  free(data->f);
+  free(data->work);
+  data->y = touch.y;
+  data->f = touch.f;
+  data->work = touch.work;
+  data->pool = pool;
+  return 1;
+error:
+  free(part);
+  free(touch.y);
+  free(touch.f);
+  free(touch.work);
+  return 0;
+}
+
+int RK4SetEquationRate(rk_data *data, enum RK4Rate const rate,
+                       unsigned const index){
+  if(!data || index >= data->eq_num ||
+     (rate != RK4_RATE_SLOW && rate != RK4_RATE_FAST)){
+    return 0;
+  }
+  data->rate[index] = rate;
+  return 1;
+}
+
+int RK4SetSubsteps(rk_data *data, unsigned const substeps){
+  if(!data || !substeps){
+    return 0;
+  }
+  data->substeps = substeps;
+  return 1;
+}
+
 int RK4Check(rk_data *data){
   if(!data || !data->eq_num){
     fprintf(stderr, "%s\n", "RK4Check: Incorrect initialization.");
@@ -108,6 +233,21 @@ int RK4Check(rk_data *data){
     fprintf(stderr, "%s\n", "RK4Check: Step must be greater then 0.");
     return 0;
   }
+  if(data->pool && data->substeps > 1){
+    fprintf(stderr, "%s\n", "RK4Check: Threaded stepping is single rate only.");
+    return 0;
+  }
+  if(data->sys || data->range){
+    if(data->substeps > 1){
+      fprintf(stderr, "%s\n", "RK4Check: Multirate stepping needs per equation right sides.");
+      return 0;
+    }
+    if(data->pool && !data->range){
+      fprintf(stderr, "%s\n", "RK4Check: Threaded stepping needs a range system right side.");
+      return 0;
+    }
+    return 1;
+  }
   for(unsigned i = 0; i< data->eq_num; i++){
     if(!data->funcs[i]){
       fprintf(stderr, "%s%d%s\n", "RK4Check: Right side functions for parameter number ", i, " not assigned.");
@@ -117,32 +257,245 @@ int RK4Check(rk_data *data){
   return 1;
 }
 
-void RK4Step(rk_data *data){
+static void RK4Eval(rk_data *data, double const x, double const *y,
+                    double *k){
+  if(data->sys){
+    data->sys(x, y, k, data->userdata);
+    return;
+  }
+  if(data->range){
+    data->range(x, y, k, 0, data->eq_num, data->userdata);
+    return;
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    k[i] = data->funcs[i](x, y, data->userdata);
+  }
+}
+
+static void RK4SingleRateStep(rk_data *data){
   double k1[data->eq_num], k2[data->eq_num], k3[data->eq_num], k4[data->eq_num];
   double y[data->eq_num];
   double yn[data->eq_num];
   double h05 = data->h * 0.5;
   double t = data->x + h05;
+  RK4Eval(data, data->x, data->y, k1);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k1[i] = data->funcs[i](data->x, data->y, data->userdata);
     y[i] = data->y[i] + h05*k1[i];
   }
+  RK4Eval(data, t, y, k2);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k2[i] = data->funcs[i](t, y, data->userdata);
     yn[i] = data->y[i] + h05*k2[i];
   }
+  RK4Eval(data, t, yn, k3);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k3[i] = data->funcs[i](t, yn, data->userdata);
     y[i] = data->y[i] + data->h*k3[i];
   }
   data->x += data->h;
+  RK4Eval(data, data->x, y, k4);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k4[i] = data->funcs[i](data->x, y, data->userdata);
     data->f[i] = 1./6*(k1[i] + 2*k2[i] + 2*k3[i] + k4[i]);
     data->y[i] += data->h * data->f[i];
   }
 }
 
+static void RK4EvalRange(rk_data *data, double const x, double const *y,
+                         double *k, unsigned const first,
+                         unsigned const last){
+  if(data->range){
+    data->range(x, y, k, first, last, data->userdata);
+    return;
+  }
+  for(unsigned i = first; i < last; i++){
+    k[i] = data->funcs[i](x, y, data->userdata);
+  }
+}
+
+/* Stage data->stage of RK4SingleRateStep restricted to one partition.
+ * Every stage reads the whole previous stage vector, so the stages are
+ * separated by PoolRunStatic barriers. */
+static void RK4StageTask(unsigned const task, unsigned const thread,
+                         void *arg){
+  rk_data *data = arg;
+  unsigned first = data->part[task];
+  unsigned last = data->part[task + 1];
+  size_t stride = RK4Stride(data->eq_num);
+  double *k1 = data->work, *k2 = k1 + stride, *k3 = k2 + stride;
+  double *k4 = k3 + stride, *y = k4 + stride, *yn = y + stride;
+  double h05 = data->h * 0.5;
+  if(first == last){
+    return;
+  }
+  switch(data->stage){
+  case 0:
+    RK4EvalRange(data, data->x, data->y, k1, first, last);
+    for(unsigned i = first; i < last; i++){
+      y[i] = data->y[i] + h05*k1[i];
+    }
+    break;
+  case 1:
+    RK4EvalRange(data, data->x + h05, y, k2, first, last);
+    for(unsigned i = first; i < last; i++){
+      yn[i] = data->y[i] + h05*k2[i];
+    }
+    break;
+  case 2:
+    RK4EvalRange(data, data->x + h05, yn, k3, first, last);
+    for(unsigned i = first; i < last; i++){
+      y[i] = data->y[i] + data->h*k3[i];
+    }
+    break;
+  default:
+    RK4EvalRange(data, data->x + data->h, y, k4, first, last);
+    for(unsigned i = first; i < last; i++){
+      data->f[i] = 1./6*(k1[i] + 2*k2[i] + 2*k3[i] + k4[i]);
+      data->y[i] += data->h * data->f[i];
+    }
+  }
+}
+
+static void RK4ThreadedStep(rk_data *data){
+  unsigned threads = PoolGetThreads(data->pool);
+  for(data->stage = 0; data->stage < 4; data->stage++){
+    PoolRunStatic(data->pool, RK4StageTask, threads, data);
+  }
+  data->x += data->h;
+}
+
+/* One classic RK4 substep of length hf for the fast equations only.
+ * Slow components are not integrated here: at every stage time they are
+ * taken from the linear prediction y0 + (t - x0)*fs made at the start of
+ * the macro step. */
+static void RK4FastSubstep(rk_data *data, double *z, double const t,
+                           double const hf, double const *y0,
+                           double const *fs){
+  double k1[data->eq_num], k2[data->eq_num], k3[data->eq_num], k4[data->eq_num];
+  double w[data->eq_num];
+  double h05 = hf * 0.5;
+  double dt = t - data->x;
+  for(unsigned i = 0; i < data->eq_num; i++){
+    w[i] = data->rate[i] == RK4_RATE_FAST ? z[i] : y0[i] + dt*fs[i];
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    if(data->rate[i] == RK4_RATE_FAST){
+      k1[i] = data->funcs[i](t, w, data->userdata);
+    }
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    w[i] = data->rate[i] == RK4_RATE_FAST ? z[i] + h05*k1[i] :
+                                            y0[i] + (dt + h05)*fs[i];
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    if(data->rate[i] == RK4_RATE_FAST){
+      k2[i] = data->funcs[i](t + h05, w, data->userdata);
+    }
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    if(data->rate[i] == RK4_RATE_FAST){
+      w[i] = z[i] + h05*k2[i];
+    }
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    if(data->rate[i] == RK4_RATE_FAST){
+      k3[i] = data->funcs[i](t + h05, w, data->userdata);
+    }
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    w[i] = data->rate[i] == RK4_RATE_FAST ? z[i] + hf*k3[i] :
+                                            y0[i] + (dt + hf)*fs[i];
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    if(data->rate[i] == RK4_RATE_FAST){
+      k4[i] = data->funcs[i](t + hf, w, data->userdata);
+      z[i] += hf/6.*(k1[i] + 2.*k2[i] + 2.*k3[i] + k4[i]);
+    }
+  }
+}
+
+/* Multirate step, fastest first: the fast group is advanced with
+ * `substeps` RK4 substeps against linearly predicted slow values, then
+ * the slow group takes one RK4 step of length h using the fast values
+ * recorded at x + h/2 and x + h. Slow right sides are evaluated 4 times
+ * per step instead of 4*substeps. */
+static void RK4MultirateStep(rk_data *data){
+  double k2[data->eq_num], k3[data->eq_num], k4[data->eq_num];
+  double fs[data->eq_num];
+  double y0[data->eq_num];
+  double ym[data->eq_num];
+  double z[data->eq_num];
+  double zprev[data->eq_num];
+  double w[data->eq_num];
+  unsigned m = data->substeps;
+  double hf = data->h / m;
+  double h05 = data->h * 0.5;
+  memcpy(y0, data->y, sizeof(double)*data->eq_num);
+  memcpy(z, data->y, sizeof(double)*data->eq_num);
+  for(unsigned i = 0; i < data->eq_num; i++){
+    fs[i] = 0.;
+    if(data->rate[i] == RK4_RATE_SLOW){
+      fs[i] = data->funcs[i](data->x, y0, data->userdata);
+    }
+  }
+  for(unsigned j = 0; j < m; j++){
+    memcpy(zprev, z, sizeof(double)*data->eq_num);
+    RK4FastSubstep(data, z, data->x + j*hf, hf, y0, fs);
+    if(2*(j + 1) == m){
+      memcpy(ym, z, sizeof(double)*data->eq_num);
+    } else if(2*j + 1 == m){
+      for(unsigned i = 0; i < data->eq_num; i++){
+        ym[i] = 0.5*(zprev[i] + z[i]);
+      }
+    }
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    w[i] = data->rate[i] == RK4_RATE_FAST ? ym[i] : y0[i] + h05*fs[i];
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    if(data->rate[i] == RK4_RATE_SLOW){
+      k2[i] = data->funcs[i](data->x + h05, w, data->userdata);
+    }
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    if(data->rate[i] == RK4_RATE_SLOW){
+      w[i] = y0[i] + h05*k2[i];
+    }
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    if(data->rate[i] == RK4_RATE_SLOW){
+      k3[i] = data->funcs[i](data->x + h05, w, data->userdata);
+    }
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    w[i] = data->rate[i] == RK4_RATE_FAST ? z[i] : y0[i] + data->h*k3[i];
+  }
+  data->x += data->h;
+  for(unsigned i = 0; i < data->eq_num; i++){
+    if(data->rate[i] == RK4_RATE_SLOW){
+      k4[i] = data->funcs[i](data->x, w, data->userdata);
+      data->f[i] = 1./6*(fs[i] + 2*k2[i] + 2*k3[i] + k4[i]);
+      data->y[i] = y0[i] + data->h * data->f[i];
+    } else {
+      data->f[i] = (z[i] - y0[i]) / data->h;
+      data->y[i] = z[i];
+    }
+  }
+}
+
+void RK4Step(rk_data *data){
+  if(data->pool){
+    RK4ThreadedStep(data);
+  } else if(data->substeps > 1){
+    RK4MultirateStep(data);
+  } else {
+    RK4SingleRateStep(data);
+  }
+}
+
+void RK4StepN(rk_data *data, unsigned const n){
+  for(unsigned i = 0; i < n; i++){
+    RK4Step(data);
+  }
+}
+
 double RK4GetY(rk_data *data, unsigned const num){
   if(!data || num >= data->eq_num){
     return 0.;
@@ -171,6 +524,13 @@ double RK4GetDY(rk_data *data, unsigned const num){
   return data->f[num];
 }
 
+double *RK4GetDYs(rk_data *data){
+  if(data){
+    return data->f;
+  }
+  return NULL;
+}
+
 int RK4SetUserData(rk_data *data, void *userdata){
   if(data){
     data->userdata = userdata;
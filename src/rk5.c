@@ -9,6 +9,7 @@ struct rk5_data_st{
   double x;
   double h;
   RK5RSFunc *funcs;
+  RK5SysFunc sys;
   void *userdata;
 };
 
@@ -99,6 +100,14 @@ int RK5SetEquations(rk5_data *data, RK5RSFunc func[],
   return 1;
 }
 
+int RK5SetSystem(rk5_data *data, RK5SysFunc func){
+  if(!data){
+    return 0;
+  }
+  data->sys = func;
+  return 1;
+}
+
 int RK5Check(rk5_data *data){
   if(!data || !data->eq_num){
     fprintf(stderr, "%s\n", "RK5Check: Incorrect initialization.");
@@ -108,6 +117,9 @@ int RK5Check(rk5_data *data){
     fprintf(stderr, "%s\n", "RK5Check: Step must be greater then 0.");
     return 0;
   }
+  if(data->sys){
+    return 1;
+  }
   for(unsigned i = 0; i< data->eq_num; i++){
     if(!data->funcs[i]){
       fprintf(stderr, "%s%d%s\n", "RK5Check: Right side functions for parameter number ", i, " not assigned.");
@@ -119,45 +131,46 @@ int RK5Check(rk5_data *data){
 
 static const double RK5_CONST[] = {1./24., 5./48., 27./56., 125./336.};
 
+static void RK5Eval(rk5_data *data, double const x, double const *y,
+                   double *k){
+  if(data->sys){
+    data->sys(x, y, k, data->userdata);
+    return;
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    k[i] = data->funcs[i](x, y, data->userdata);
+  }
+}
+
 void RK5Step(rk5_data *data){
   double k1[data->eq_num], k2[data->eq_num], k3[data->eq_num],
          k4[data->eq_num], k5[data->eq_num], k6[data->eq_num];
   double y[data->eq_num];
   double yn[data->eq_num];
+  RK5Eval(data, data->x, data->y, k1);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k1[i] = data->funcs[i](data->x, data->y, data->userdata);
     y[i] = data->y[i] + 0.5*data->h*k1[i];
   }
+  RK5Eval(data, data->x + 0.5*data->h, y, k2);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k2[i] = data->funcs[i](data->x + 0.5*data->h,
-                           y,
-                           data->userdata);
     yn[i] = data->y[i] + 0.25*data->h*(k1[i] + k2[i]);
   }
+  RK5Eval(data, data->x + 0.5*data->h, yn, k3);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k3[i] = data->funcs[i](data->x + 0.5*data->h,
-                           yn,
-                           data->userdata);
     y[i] = data->y[i] + data->h*(2.*k3[i] - k2[i]);
   }
+  RK5Eval(data, data->x + data->h, y, k4);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k4[i] = data->funcs[i](data->x + data->h,
-                           y,
-                           data->userdata);
     yn[i] = data->y[i] + 1./27.*data->h*(7.*k1[i] + 10.*k2[i]+k4[i]);
   }
+  RK5Eval(data, data->x + 2./3.*data->h, yn, k5);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k5[i] = data->funcs[i](data->x + 2./3.*data->h,
-                           yn,
-                           data->userdata);
     y[i] = data->y[i] + 1./625.*data->h*(28.*k1[i] - 125.*k2[i] +
                                          546.*k3[i] + 54.*k4[i] -
                                          378.*k5[i]);
   }
+  RK5Eval(data, data->x + 1./5.*data->h, y, k6);
   for(unsigned i = 0; i < data->eq_num; i++){
-    k6[i] = data->funcs[i](data->x + 1./5.*data->h,
-                           y,
-                           data->userdata);
     data->f[i] = RK5_CONST[0]*k1[i] + RK5_CONST[1]*k4[i] +
                  RK5_CONST[2]*k5[i] + RK5_CONST[3]*k6[i];
     data->y[i] += data->h*data->f[i];
@@ -165,6 +178,12 @@ void RK5Step(rk5_data *data){
   data->x += data->h;
 }
 
+void RK5StepN(rk5_data *data, unsigned const n){
+  for(unsigned i = 0; i < n; i++){
+    RK5Step(data);
+  }
+}
+
 double RK5GetY(rk5_data *data, unsigned const num){
   if(!data || num >= data->eq_num){
     return 0.;
@@ -193,6 +212,13 @@ double RK5GetDY(rk5_data *data, unsigned const num){
   return data->f[num];
 }
 
+double *RK5GetDYs(rk5_data *data){
+  if(data){
+    return data->f;
+  }
+  return NULL;
+}
+
 int RK5SetUserData(rk5_data *data, void *userdata){
   if(data){
     data->userdata = userdata;
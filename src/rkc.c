@@ -0,0 +1,348 @@
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "float.h"
+#include "rkc.h"
+
+/* Second order Runge-Kutta-Chebyshev method (Sommeijer, Shampine and
+ * Verwer 1997) with damping 2/13. An s stage step is stable for
+ * h rho <= 0.653 s^2, so s = 1 + sqrt(1 + 1.54 h rho) grows only with the
+ * square root of the stiffness. The stages follow a three term
+ * recurrence, so a step of any length keeps just Y_j, Y_{j-1}, Y_{j-2}
+ * and two right side vectors besides y. */
+
+struct rkc_data_st{
+  unsigned eq_num;
+  double *y;
+  double *f0;
+  double *fj;
+  double *yj;
+  double *yjm1;
+  double *yjm2;
+  double *v;
+  double x;
+  double h;
+  double rho;
+  unsigned stages;
+  unsigned period;
+  unsigned since;
+  double rho_h;
+  RKCRSFunc *funcs;
+  RKCSysFunc sys;
+  RKCRadiusFunc radius;
+  void *userdata;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+#define RKC_EPS (2./13.)
+
+int RKCInitData(rkc_data **data, unsigned const eq_num){
+  *data = calloc(1, sizeof(rkc_data));
+  EXIT_IF_NULL(*data);
+  (*data)->eq_num = eq_num;
+  (*data)->y = calloc(7*eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->y);
+  (*data)->f0 = (*data)->y + eq_num;
+  (*data)->fj = (*data)->f0 + eq_num;
+  (*data)->yj = (*data)->fj + eq_num;
+  (*data)->yjm1 = (*data)->yj + eq_num;
+  (*data)->yjm2 = (*data)->yjm1 + eq_num;
+  (*data)->v = (*data)->yjm2 + eq_num;
+  (*data)->funcs = calloc(eq_num, sizeof(RKCRSFunc));
+  EXIT_IF_NULL((*data)->funcs);
+  (*data)->period = 25;
+  return 1;
+error:
+  if(*data){
+    free((*data)->y);
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void RKCFreeData(rkc_data *data){
+  if(data){
+    free(data->funcs);
+    free(data->y);
+    free(data);
+  }
+}
+
+int RKCSetYs0(rkc_data *data, double const ys[],
+              unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->y[i] = ys[i];
+  }
+  return 1;
+}
+
+int RKCSetY0(rkc_data *data, double const y, unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0;
+  }
+  data->y[index] = y;
+  return 1;
+}
+
+int RKCSetX(rkc_data *data, double const t){
+  if(!data){
+    return 0;
+  }
+  data->x = t;
+  return 1;
+}
+
+int RKCSetStep(rkc_data *data, double const step){
+  if(!data){
+    return 0;
+  }
+  data->h = step;
+  return 1;
+}
+
+int RKCSetEquation(rkc_data *data, RKCRSFunc func,
+                   unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0;
+  }
+  data->funcs[index] = func;
+  return 1;
+}
+
+int RKCSetEquations(rkc_data *data, RKCRSFunc func[],
+                    unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->funcs[i] = func[i];
+  }
+  return 1;
+}
+
+int RKCSetSystem(rkc_data *data, RKCSysFunc func){
+  if(!data){
+    return 0;
+  }
+  data->sys = func;
+  return 1;
+}
+
+int RKCSetSpectralRadius(rkc_data *data, RKCRadiusFunc func){
+  if(!data){
+    return 0;
+  }
+  data->radius = func;
+  return 1;
+}
+
+int RKCSetRadiusPeriod(rkc_data *data, unsigned const period){
+  if(!data || !period){
+    return 0;
+  }
+  data->period = period;
+  return 1;
+}
+
+int RKCCheck(rkc_data *data){
+  if(!data || !data->eq_num){
+    fprintf(stderr, "%s\n", "RKCCheck: Incorrect initialization.");
+    return 0;
+  }
+  if(data->h <= 0.){
+    fprintf(stderr, "%s\n", "RKCCheck: Step must be greater then 0.");
+    return 0;
+  }
+  if(data->sys){
+    return 1;
+  }
+  for(unsigned i = 0; i< data->eq_num; i++){
+    if(!data->funcs[i]){
+      fprintf(stderr, "%s%d%s\n", "RKCCheck: Right side functions for parameter number ", i, " not assigned.");
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void RKCEval(rkc_data *data, double const x, double const *y,
+                    double *k){
+  if(data->sys){
+    data->sys(x, y, k, data->userdata);
+    return;
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    k[i] = data->funcs[i](x, y, data->userdata);
+  }
+}
+
+static double RKCNorm(double const *v, unsigned const n){
+  double sum = 0.;
+  for(unsigned i = 0; i < n; i++){
+    sum += v[i]*v[i];
+  }
+  return sqrt(sum);
+}
+
+/* Power iteration on J v ~ (F(y + d v) - F(y)) / d, started from the
+ * vector of the previous estimate and using f0 = F(y) as the base. The
+ * first start vector adds an oscillating pattern to f0, since f0 alone
+ * is often close to the smoothest (slowest) mode. The stage buffers are
+ * free here and serve as scratch. */
+static double RKCPowerIteration(rkc_data *data){
+  unsigned n = data->eq_num;
+  double *z = data->yj, *fz = data->fj;
+  double ynorm = RKCNorm(data->y, n);
+  double scale = sqrt(DBL_EPSILON)*(ynorm > 1. ? ynorm : 1.);
+  double sigma = 0.;
+  if(0. == RKCNorm(data->v, n)){
+    double fnorm = RKCNorm(data->f0, n);
+    double amp = (fnorm > 0. ? fnorm : 1.) / sqrt(n);
+    for(unsigned i = 0; i < n; i++){
+      data->v[i] = data->f0[i] + amp*(i % 2 ? 1. : -1.)*(1. + 0.01*i);
+    }
+  }
+  for(unsigned iter = 0; iter < 50; iter++){
+    double vnorm = RKCNorm(data->v, n);
+    if(0. == vnorm){
+      break;
+    }
+    for(unsigned i = 0; i < n; i++){
+      z[i] = data->y[i] + scale / vnorm * data->v[i];
+    }
+    RKCEval(data, data->x, z, fz);
+    for(unsigned i = 0; i < n; i++){
+      data->v[i] = fz[i] - data->f0[i];
+    }
+    double prev = sigma;
+    sigma = RKCNorm(data->v, n) / scale;
+    if(iter && fabs(sigma - prev) <= 0.01*sigma){
+      break;
+    }
+  }
+  return 1.2*sigma;
+}
+
+void RKCStep(rkc_data *data){
+  unsigned n = data->eq_num;
+  double h = data->h;
+  RKCEval(data, data->x, data->y, data->f0);
+  if(data->radius){
+    data->rho = data->radius(data->x, data->y, data->userdata);
+  } else if(!data->since || data->rho_h != h){
+    data->rho = RKCPowerIteration(data);
+    data->rho_h = h;
+  }
+  data->since = (data->since + 1) % data->period;
+  unsigned s = 1 + (unsigned)sqrt(1. + 1.54*h*data->rho);
+  s = s < 2 ? 2 : s;
+  data->stages = s;
+  double w0 = 1. + RKC_EPS/(s*s);
+  /* T_s, T_s' and T_s'' at w0 give w1 */
+  double t0 = 1., t1 = w0, d0 = 0., d1 = 1., dd0 = 0., dd1 = 0.;
+  for(unsigned j = 2; j <= s; j++){
+    double t2 = 2.*w0*t1 - t0;
+    double d2 = 2.*t1 + 2.*w0*d1 - d0;
+    double dd2 = 4.*d1 + 2.*w0*dd1 - dd0;
+    t0 = t1; t1 = t2; d0 = d1; d1 = d2; dd0 = dd1; dd1 = dd2;
+  }
+  double w1 = d1 / dd1;
+  /* b_j = T_j''(w0) / T_j'(w0)^2 for j >= 2, b_0 = b_1 = b_2 */
+  double b2 = 4. / (16.*w0*w0);
+  double bjm2 = b2, bjm1 = b2;
+  double tjm2 = 1., tjm1 = w0, djm2 = 0., djm1 = 1., ddjm2 = 0., ddjm1 = 0.;
+  double mut1 = bjm1*w1;
+  double cjm2 = 0., cjm1 = mut1;
+  double *ym2 = data->yjm2, *ym1 = data->yjm1, *yc = data->yj;
+  for(unsigned i = 0; i < n; i++){
+    ym2[i] = data->y[i];
+    ym1[i] = data->y[i] + mut1*h*data->f0[i];
+  }
+  for(unsigned j = 2; j <= s; j++){
+    double tj = 2.*w0*tjm1 - tjm2;
+    double dj = 2.*tjm1 + 2.*w0*djm1 - djm2;
+    double ddj = 4.*djm1 + 2.*w0*ddjm1 - ddjm2;
+    double bj = ddj / (dj*dj);
+    double mu = 2.*w0*bj / bjm1;
+    double nu = -bj / bjm2;
+    double mut = 2.*w1*bj / bjm1;
+    double gat = -(1. - bjm1*tjm1)*mut;
+    RKCEval(data, data->x + cjm1*h, ym1, data->fj);
+    for(unsigned i = 0; i < n; i++){
+      yc[i] = (1. - mu - nu)*data->y[i] + mu*ym1[i] + nu*ym2[i] +
+              mut*h*data->fj[i] + gat*h*data->f0[i];
+    }
+    double cj = mu*cjm1 + nu*cjm2 + mut + gat;
+    double *tmp = ym2;
+    ym2 = ym1;
+    ym1 = yc;
+    yc = tmp;
+    cjm2 = cjm1;
+    cjm1 = cj;
+    bjm2 = bjm1;
+    bjm1 = bj;
+    tjm2 = tjm1;
+    tjm1 = tj;
+    djm2 = djm1;
+    djm1 = dj;
+    ddjm2 = ddjm1;
+    ddjm1 = ddj;
+  }
+  memcpy(data->y, ym1, sizeof(double)*n);
+  data->x += h;
+}
+
+void RKCStepN(rkc_data *data, unsigned const n){
+  for(unsigned i = 0; i < n; i++){
+    RKCStep(data);
+  }
+}
+
+double RKCGetY(rkc_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->y[num];
+}
+
+double *RKCGetYs(rkc_data *data){
+  if(data){
+    return data->y;
+  }
+  return NULL;
+}
+
+double RKCGetX(rkc_data *data){
+  if(data){
+    return data->x;
+  }
+  return 0.;
+}
+
+double RKCGetSpectralRadius(rkc_data *data){
+  if(data){
+    return data->rho;
+  }
+  return 0.;
+}
+
+unsigned RKCGetStages(rkc_data *data){
+  if(data){
+    return data->stages;
+  }
+  return 0;
+}
+
+int RKCSetUserData(rkc_data *data, void *userdata){
+  if(data){
+    data->userdata = userdata;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "stdint.h"
+#include "rkn.h"
+
+/* Runge-Kutta-Nystrom methods for y'' = f(x, y). Stages only evaluate
+ * f for the N positions, so the y' = v half of the first order form
+ * costs nothing.
+ * RKN_4: 3 stages, c = (0, 1/2, 1), order 4.
+ * RKN_5: Nystrom's 4 stage method of order 5 with an embedded order 3
+ * solution on the same stages used for step size control. */
+
+struct rkn_data_st{
+  unsigned eq_num;
+  enum RKNMethod method;
+  double *y;
+  double *v;
+  double x;
+  double h;
+  double atol;
+  double rtol;
+  RKNRSFunc *funcs;
+  RKNSysFunc sys;
+  void *userdata;
+};
+
+static const double RKN5_C[] = {0., 1./5., 2./3., 1.};
+static const double RKN5_A[4][3] = {{0., 0., 0.},
+                                    {1./50., 0., 0.},
+                                    {-1./27., 7./27., 0.},
+                                    {3./10., -2./35., 9./35.}};
+static const double RKN5_BY[] = {14./336., 100./336., 54./336., 0.};
+static const double RKN5_BV[] = {14./336., 125./336., 162./336., 35./336.};
+static const double RKN5_EY[] = {-70./336., 100./336., -30./336., 0.};
+static const double RKN5_EV[] = {-70./336., 125./336., -90./336., 35./336.};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+#define RKN_MAX_REJECTS 64
+
+int RKNInitData(rkn_data **data, unsigned const eq_num){
+  *data = calloc(1, sizeof(rkn_data));
+  EXIT_IF_NULL(*data);
+  (*data)->eq_num = eq_num;
+  (*data)->y = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->y);
+  (*data)->v = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->v);
+  (*data)->funcs = calloc(eq_num, sizeof(RKNRSFunc));
+  EXIT_IF_NULL((*data)->funcs);
+  (*data)->method = RKN_4;
+  return 1;
+error:
+  if(*data){
+    free((*data)->v);
+    free((*data)->y);
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void RKNFreeData(rkn_data *data){
+  if(data){
+    free(data->funcs);
+    free(data->v);
+    free(data->y);
+    free(data);
+  }
+}
+
+int RKNSetMethod(rkn_data *data, enum RKNMethod const method){
+  if(!data || (method != RKN_4 && method != RKN_5)){
+    return 0;
+  }
+  data->method = method;
+  return 1;
+}
+
+int RKNSetYs0(rkn_data *data, double const ys[],
+              unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->y[i] = ys[i];
+  }
+  return 1;
+}
+
+int RKNSetY0(rkn_data *data, double const y, unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0;
+  }
+  data->y[index] = y;
+  return 1;
+}
+
+int RKNSetDYs0(rkn_data *data, double const dys[],
+               unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->v[i] = dys[i];
+  }
+  return 1;
+}
+
+int RKNSetDY0(rkn_data *data, double const dy, unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0;
+  }
+  data->v[index] = dy;
+  return 1;
+}
+
+int RKNSetX(rkn_data *data, double const t){
+  if(!data){
+    return 0;
+  }
+  data->x = t;
+  return 1;
+}
+
+int RKNSetStep(rkn_data *data, double const step){
+  if(!data){
+    return 0;
+  }
+  data->h = step;
+  return 1;
+}
+
+int RKNSetTolerance(rkn_data *data, double const atol, double const rtol){
+  if(!data || atol < 0. || rtol < 0.){
+    return 0;
+  }
+  data->atol = atol;
+  data->rtol = rtol;
+  return 1;
+}
+
+int RKNSetEquation(rkn_data *data, RKNRSFunc func,
+                   unsigned const index){
+  if(!data || index >= data->eq_num){
+      return 0;
+    }
+  data->funcs[index] = func;
+  return 1;
+}
+
+int RKNSetEquations(rkn_data *data, RKNRSFunc func[],
+                    unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->funcs[i] = func[i];
+  }
+  return 1;
+}
+
+int RKNSetSystem(rkn_data *data, RKNSysFunc func){
+  if(!data){
+    return 0;
+  }
+  data->sys = func;
+  return 1;
+}
+
+int RKNCheck(rkn_data *data){
+  if(!data || !data->eq_num){
+    fprintf(stderr, "%s\n", "RKNCheck: Incorrect initialization.");
+    return 0;
+  }
+  if(0. == data->h){
+    fprintf(stderr, "%s\n", "RKNCheck: Step must be greater then 0.");
+    return 0;
+  }
+  if(data->sys){
+    return 1;
+  }
+  for(unsigned i = 0; i< data->eq_num; i++){
+    if(!data->funcs[i]){
+      fprintf(stderr, "%s%d%s\n", "RKNCheck: Right side functions for parameter number ", i, " not assigned.");
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void RKNEval(rkn_data *data, double const x, double const *y,
+                    double *k){
+  if(data->sys){
+    data->sys(x, y, k, data->userdata);
+    return;
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    k[i] = data->funcs[i](x, y, data->userdata);
+  }
+}
+
+static void RKN4Step(rkn_data *data){
+  double k1[data->eq_num], k2[data->eq_num], k3[data->eq_num];
+  double y[data->eq_num];
+  double h = data->h;
+  double hh = h*h;
+  RKNEval(data, data->x, data->y, k1);
+  for(unsigned i = 0; i < data->eq_num; i++){
+    y[i] = data->y[i] + 0.5*h*data->v[i] + 0.125*hh*k1[i];
+  }
+  RKNEval(data, data->x + 0.5*h, y, k2);
+  for(unsigned i = 0; i < data->eq_num; i++){
+    y[i] = data->y[i] + h*data->v[i] + 0.5*hh*k2[i];
+  }
+  RKNEval(data, data->x + h, y, k3);
+  for(unsigned i = 0; i < data->eq_num; i++){
+    data->y[i] += h*data->v[i] + hh/6.*(k1[i] + 2.*k2[i]);
+    data->v[i] += h/6.*(k1[i] + 4.*k2[i] + k3[i]);
+  }
+  data->x += h;
+}
+
+/* Returns the scaled RMS error of the step, 0 without a tolerance. */
+static double RKN5Try(rkn_data *data, double *yn, double *vn){
+  double k[4][data->eq_num];
+  double y[data->eq_num];
+  double h = data->h;
+  double hh = h*h;
+  double err = 0.;
+  RKNEval(data, data->x, data->y, k[0]);
+  for(unsigned s = 1; s < 4; s++){
+    for(unsigned i = 0; i < data->eq_num; i++){
+      double acc = 0.;
+      for(unsigned j = 0; j < s; j++){
+        acc += RKN5_A[s][j]*k[j][i];
+      }
+      y[i] = data->y[i] + RKN5_C[s]*h*data->v[i] + hh*acc;
+    }
+    RKNEval(data, data->x + RKN5_C[s]*h, y, k[s]);
+  }
+  for(unsigned i = 0; i < data->eq_num; i++){
+    double by = 0., bv = 0., ey = 0., ev = 0.;
+    for(unsigned s = 0; s < 4; s++){
+      by += RKN5_BY[s]*k[s][i];
+      bv += RKN5_BV[s]*k[s][i];
+      ey += RKN5_EY[s]*k[s][i];
+      ev += RKN5_EV[s]*k[s][i];
+    }
+    yn[i] = data->y[i] + h*data->v[i] + hh*by;
+    vn[i] = data->v[i] + h*bv;
+    if(data->atol > 0. || data->rtol > 0.){
+      double sy = data->atol + data->rtol*fmax(fabs(data->y[i]), fabs(yn[i]));
+      double sv = data->atol + data->rtol*fmax(fabs(data->v[i]), fabs(vn[i]));
+      ey *= hh/sy;
+      ev *= h/sv;
+      err += ey*ey + ev*ev;
+    }
+  }
+  return sqrt(err/(2*data->eq_num));
+}
+
+/* Bitwise, since -ffast-math lets the compiler assume isfinite(). */
+static int RKNFinite(double const v){
+  uint64_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  return (bits >> 52 & 0x7FF) != 0x7FF;
+}
+
+static int RKN5Step(rkn_data *data){
+  double yn[data->eq_num], vn[data->eq_num];
+  double const h0 = data->h;
+  int adaptive = data->atol > 0. || data->rtol > 0.;
+  for(unsigned rejects = 0; rejects < RKN_MAX_REJECTS; rejects++){
+    double err = RKN5Try(data, yn, vn);
+    int finite = RKNFinite(err);
+    double fac = !finite ? 0.2 : (err > 0. ? 0.9*pow(err, -0.25) : 4.);
+    fac = fac < 0.2 ? 0.2 : (fac > 4. ? 4. : fac);
+    if(!adaptive || (finite && err <= 1.)){
+      memcpy(data->y, yn, sizeof(double)*data->eq_num);
+      memcpy(data->v, vn, sizeof(double)*data->eq_num);
+      data->x += data->h;
+      if(adaptive){
+        data->h *= fac;
+      }
+      return 1;
+    }
+    data->h *= fac;
+  }
+  data->h = h0;
+  return 0;
+}
+
+int RKNStep(rkn_data *data){
+  if(RKN_5 == data->method){
+    return RKN5Step(data);
+  }
+  RKN4Step(data);
+  return 1;
+}
+
+int RKNStepN(rkn_data *data, unsigned const n){
+  for(unsigned i = 0; i < n; i++){
+    if(!RKNStep(data)){
+      return 0;
+    }
+  }
+  return 1;
+}
+
+double RKNGetY(rkn_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->y[num];
+}
+
+double *RKNGetYs(rkn_data *data){
+  if(data){
+    return data->y;
+  }
+  return NULL;
+}
+
+double RKNGetDY(rkn_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->v[num];
+}
+
+double *RKNGetDYs(rkn_data *data){
+  if(data){
+    return data->v;
+  }
+  return NULL;
+}
+
+double RKNGetX(rkn_data *data){
+  if(data){
+    return data->x;
+  }
+  return 0.;
+}
+
+double RKNGetStep(rkn_data *data){
+  if(data){
+    return data->h;
+  }
+  return 0.;
+}
+
+int RKNSetUserData(rkn_data *data, void *userdata){
+  if(data){
+    data->userdata = userdata;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,291 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "pthread.h"
+#include "runner.h"
+#include "pool.h"
+#include "rk4.h"
+#include "rk5.h"
+#include "adams.h"
+#include "adams5.h"
+
+/* Every thread owns a deque of job indices, kept as the range
+ * [top, bottom) since jobs are only ever handed out in contiguous runs.
+ * The owner pops from the bottom; a thief takes the upper half of the
+ * range from the top of the first victim that has work and makes it
+ * its own deque. A thread leaves when no deque has work left; jobs
+ * in flight between two deques are always finished by the thief. */
+
+struct runner_worker_st{
+  pthread_mutex_t lock;
+  unsigned top;
+  unsigned bottom;
+  unsigned long steals;
+  unsigned eq_num[RUNNER_SOLVERS];
+  rk_data *rk4;
+  rk5_data *rk5;
+  a_data *adams;
+  a5_data *adams5;
+};
+
+struct runner_data_st{
+  pool_data *pool;
+  unsigned threads;
+  struct runner_worker_st *workers;
+  runner_job *jobs;
+  int failed;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+int RunnerInitData(runner_data **data, unsigned const threads){
+  *data = calloc(1, sizeof(runner_data));
+  EXIT_IF_NULL(*data);
+  (*data)->threads = threads ? threads : 1;
+  (*data)->workers = calloc((*data)->threads,
+                            sizeof(struct runner_worker_st));
+  EXIT_IF_NULL((*data)->workers);
+  for(unsigned t = 0; t < (*data)->threads; t++){
+    pthread_mutex_init(&(*data)->workers[t].lock, NULL);
+  }
+  if(!PoolInitData(&(*data)->pool, (*data)->threads)){
+    goto error;
+  }
+  return 1;
+error:
+  if(*data){
+    if((*data)->workers){
+      for(unsigned t = 0; t < (*data)->threads; t++){
+        pthread_mutex_destroy(&(*data)->workers[t].lock);
+      }
+    }
+    free((*data)->workers);
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void RunnerFreeData(runner_data *data){
+  if(data){
+    PoolFreeData(data->pool);
+    for(unsigned t = 0; t < data->threads; t++){
+      struct runner_worker_st *w = data->workers + t;
+      RK4FreeData(w->rk4);
+      RK5FreeData(w->rk5);
+      AdamsFreeData(w->adams);
+      Adams5FreeData(w->adams5);
+      pthread_mutex_destroy(&w->lock);
+    }
+    free(data->workers);
+    free(data);
+  }
+}
+
+/* Makes the thread's solver of the job's kind fit eq_num and loads the
+ * job into it. */
+static int RunnerPrepare(struct runner_worker_st *w, runner_job *job){
+  unsigned n = job->eq_num;
+  int fits = w->eq_num[job->solver] == n;
+  w->eq_num[job->solver] = n;
+  switch(job->solver){
+  case RUNNER_RK4:
+    if(!fits){
+      RK4FreeData(w->rk4);
+      if(!RK4InitData(&w->rk4, n)){
+        break;
+      }
+    }
+    return RK4SetYs0(w->rk4, job->y0, n) && RK4SetX(w->rk4, job->x0) &&
+           RK4SetStep(w->rk4, job->h) && RK4SetSystem(w->rk4, job->func) &&
+           RK4SetUserData(w->rk4, job->userdata);
+  case RUNNER_RK5:
+    if(!fits){
+      RK5FreeData(w->rk5);
+      if(!RK5InitData(&w->rk5, n)){
+        break;
+      }
+    }
+    return RK5SetYs0(w->rk5, job->y0, n) && RK5SetX(w->rk5, job->x0) &&
+           RK5SetStep(w->rk5, job->h) && RK5SetSystem(w->rk5, job->func) &&
+           RK5SetUserData(w->rk5, job->userdata);
+  case RUNNER_ADAMS:
+    if(!fits){
+      AdamsFreeData(w->adams);
+      if(!AdamsInitData(&w->adams, n)){
+        break;
+      }
+    }
+    return AdamsSetYs0(w->adams, job->y0, n) &&
+           AdamsSetX(w->adams, job->x0) &&
+           AdamsSetStep(w->adams, job->h) &&
+           AdamsSetSystem(w->adams, job->func) &&
+           AdamsSetUserData(w->adams, job->userdata);
+  case RUNNER_ADAMS5:
+    if(!fits){
+      Adams5FreeData(w->adams5);
+      if(!Adams5InitData(&w->adams5, n)){
+        break;
+      }
+    }
+    return Adams5SetYs0(w->adams5, job->y0, n) &&
+           Adams5SetX(w->adams5, job->x0) &&
+           Adams5SetStep(w->adams5, job->h) &&
+           Adams5SetSystem(w->adams5, job->func) &&
+           Adams5SetUserData(w->adams5, job->userdata);
+  default:
+    return 0;
+  }
+  w->eq_num[job->solver] = 0;
+  return 0;
+}
+
+/* Advances the prepared solver by one step of h (re-set only when the
+ * last step is shortened) and returns its state. */
+static double *RunnerStep(struct runner_worker_st *w, runner_job *job,
+                          double const h, int const reset, double *x){
+  switch(job->solver){
+  case RUNNER_RK4:
+    if(reset){
+      RK4SetStep(w->rk4, h);
+    }
+    RK4Step(w->rk4);
+    *x = RK4GetX(w->rk4);
+    return RK4GetYs(w->rk4);
+  case RUNNER_RK5:
+    if(reset){
+      RK5SetStep(w->rk5, h);
+    }
+    RK5Step(w->rk5);
+    *x = RK5GetX(w->rk5);
+    return RK5GetYs(w->rk5);
+  case RUNNER_ADAMS:
+    if(reset){
+      AdamsSetStep(w->adams, h);
+    }
+    AdamsStep(w->adams);
+    *x = AdamsGetX(w->adams);
+    return AdamsGetYs(w->adams);
+  default:
+    if(reset){
+      Adams5SetStep(w->adams5, h);
+    }
+    Adams5Step(w->adams5);
+    *x = Adams5GetX(w->adams5);
+    return Adams5GetYs(w->adams5);
+  }
+}
+
+static int RunnerSolveJob(struct runner_worker_st *w, runner_job *job){
+  job->steps = 0;
+  job->x = job->x0;
+  if(!job->func || !job->y0 || !job->eq_num || job->h <= 0. ||
+     job->x_end < job->x0 || !RunnerPrepare(w, job)){
+    return 0;
+  }
+  double x = job->x0;
+  double const *ys = job->y0;
+  while(job->x_end - x > 1.E-12*job->h){
+    double h = job->h;
+    int last = x + h > job->x_end;
+    if(last){
+      h = job->x_end - x;
+    }
+    ys = RunnerStep(w, job, h, last, &x);
+    job->steps++;
+    if(job->stop && job->stop(x, ys, job->userdata)){
+      break;
+    }
+  }
+  job->x = x;
+  if(job->y){
+    memcpy(job->y, ys, sizeof(double)*job->eq_num);
+  }
+  return 1;
+}
+
+static int RunnerPop(struct runner_worker_st *w, unsigned *job){
+  int found = 0;
+  pthread_mutex_lock(&w->lock);
+  if(w->top < w->bottom){
+    *job = --w->bottom;
+    found = 1;
+  }
+  pthread_mutex_unlock(&w->lock);
+  return found;
+}
+
+static int RunnerSteal(runner_data *data, unsigned const thread){
+  struct runner_worker_st *own = data->workers + thread;
+  for(unsigned k = 1; k < data->threads; k++){
+    struct runner_worker_st *victim =
+      data->workers + (thread + k) % data->threads;
+    unsigned first = 0, last = 0;
+    pthread_mutex_lock(&victim->lock);
+    if(victim->top < victim->bottom){
+      first = victim->top;
+      last = first + (victim->bottom - victim->top + 1) / 2;
+      victim->top = last;
+    }
+    pthread_mutex_unlock(&victim->lock);
+    if(first < last){
+      pthread_mutex_lock(&own->lock);
+      own->top = first;
+      own->bottom = last;
+      own->steals++;
+      pthread_mutex_unlock(&own->lock);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void RunnerTask(unsigned const task, unsigned const thread,
+                       void *arg){
+  runner_data *data = arg;
+  struct runner_worker_st *w = data->workers + thread;
+  unsigned job;
+  do{
+    while(RunnerPop(w, &job)){
+      data->jobs[job].status = RunnerSolveJob(w, data->jobs + job);
+      if(!data->jobs[job].status){
+        __atomic_store_n(&data->failed, 1, __ATOMIC_RELAXED);
+      }
+    }
+  }while(RunnerSteal(data, thread));
+}
+
+int RunnerRun(runner_data *data, runner_job jobs[], unsigned const num){
+  if(!data || (!jobs && num)){
+    return 0;
+  }
+  data->jobs = jobs;
+  data->failed = 0;
+  for(unsigned t = 0; t < data->threads; t++){
+    struct runner_worker_st *w = data->workers + t;
+    w->top = (unsigned)((unsigned long)num * t / data->threads);
+    w->bottom = (unsigned)((unsigned long)num * (t + 1) / data->threads);
+    w->steals = 0;
+  }
+  PoolRunStatic(data->pool, RunnerTask, data->threads, data);
+  return !data->failed;
+}
+
+unsigned RunnerGetThreads(runner_data *data){
+  if(data){
+    return data->threads;
+  }
+  return 0;
+}
+
+unsigned long RunnerGetSteals(runner_data *data){
+  unsigned long steals = 0;
+  if(data){
+    for(unsigned t = 0; t < data->threads; t++){
+      steals += data->workers[t].steals;
+    }
+  }
+  return steals;
+}
@@ -0,0 +1,305 @@
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "sde.h"
+
+/* Normals come from Philox4x32-10 keyed by (seed, path) with a 64 bit
+ * block counter in the first two counter words. Every step draws whole
+ * blocks of four uniforms, so the stream position after n steps does
+ * not depend on anything but n. The uniforms of a step are generated
+ * first and turned into normals by one Box-Muller pass over the batch. */
+
+struct sde_data_st{
+  unsigned eq_num;
+  enum SDEMethod method;
+  double *y;
+  double *w;
+  double x;
+  double h;
+  uint32_t key[2];
+  uint64_t block;
+  SDEDriftFunc drift;
+  SDEDiffusionFunc diffusion;
+  void *userdata;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+#define SDE_PHILOX_M0 0xD2511F53u
+#define SDE_PHILOX_M1 0xCD9E8D57u
+#define SDE_PHILOX_W0 0x9E3779B9u
+#define SDE_PHILOX_W1 0xBB67AE85u
+#define SDE_TWO_PI 6.283185307179586476925286766559
+
+void SDEPhilox(uint32_t const ctr[4], uint32_t const key[2],
+               uint32_t out[4]){
+  uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+  uint32_t k0 = key[0], k1 = key[1];
+  for(unsigned r = 0; r < 10; r++){
+    uint64_t p0 = (uint64_t)SDE_PHILOX_M0 * c0;
+    uint64_t p1 = (uint64_t)SDE_PHILOX_M1 * c2;
+    c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+    c1 = (uint32_t)p1;
+    c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+    c3 = (uint32_t)p0;
+    k0 += SDE_PHILOX_W0;
+    k1 += SDE_PHILOX_W1;
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+int SDEInitData(sde_data **data, unsigned const eq_num){
+  *data = calloc(1, sizeof(sde_data));
+  EXIT_IF_NULL(*data);
+  (*data)->eq_num = eq_num;
+  (*data)->y = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->y);
+  (*data)->w = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->w);
+  (*data)->method = SDE_EULER_MARUYAMA;
+  return 1;
+error:
+  if(*data){
+    free((*data)->y);
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void SDEFreeData(sde_data *data){
+  if(data){
+    free(data->w);
+    free(data->y);
+    free(data);
+  }
+}
+
+int SDESetMethod(sde_data *data, enum SDEMethod const method){
+  if(!data || (method != SDE_EULER_MARUYAMA && method != SDE_MILSTEIN &&
+               method != SDE_SRA1)){
+    return 0;
+  }
+  data->method = method;
+  return 1;
+}
+
+int SDESetYs0(sde_data *data, double const ys[],
+              unsigned const num){
+  if(!data || num != data->eq_num){
+    return 0;
+  }
+  for(unsigned i = 0; i<num; i++){
+    data->y[i] = ys[i];
+  }
+  return 1;
+}
+
+int SDESetY0(sde_data *data, double const y, unsigned const index){
+  if(!data || index >= data->eq_num){
+    return 0;
+  }
+  data->y[index] = y;
+  return 1;
+}
+
+int SDESetX(sde_data *data, double const t){
+  if(!data){
+    return 0;
+  }
+  data->x = t;
+  return 1;
+}
+
+int SDESetStep(sde_data *data, double const step){
+  if(!data){
+    return 0;
+  }
+  data->h = step;
+  return 1;
+}
+
+int SDESetDrift(sde_data *data, SDEDriftFunc func){
+  if(!data){
+    return 0;
+  }
+  data->drift = func;
+  return 1;
+}
+
+int SDESetDiffusion(sde_data *data, SDEDiffusionFunc func){
+  if(!data){
+    return 0;
+  }
+  data->diffusion = func;
+  return 1;
+}
+
+int SDESetStream(sde_data *data, uint32_t const seed, uint32_t const path){
+  if(!data){
+    return 0;
+  }
+  data->key[0] = seed;
+  data->key[1] = path;
+  data->block = 0;
+  memset(data->w, 0, sizeof(double)*data->eq_num);
+  return 1;
+}
+
+int SDECheck(sde_data *data){
+  if(!data || !data->eq_num){
+    fprintf(stderr, "%s\n", "SDECheck: Incorrect initialization.");
+    return 0;
+  }
+  if(data->h <= 0.){
+    fprintf(stderr, "%s\n", "SDECheck: Step must be greater then 0.");
+    return 0;
+  }
+  if(!data->drift || !data->diffusion){
+    fprintf(stderr, "%s\n", "SDECheck: Drift and diffusion functions not assigned.");
+    return 0;
+  }
+  return 1;
+}
+
+/* Fills z[0..num) with standard normals, num even. */
+static void SDENormals(sde_data *data, double *z, unsigned const num){
+  unsigned blocks = (num + 3) / 4;
+  double u[4*blocks];
+  for(unsigned j = 0; j < blocks; j++){
+    uint32_t ctr[4] = {(uint32_t)data->block, (uint32_t)(data->block >> 32),
+                       0, 0};
+    uint32_t out[4];
+    SDEPhilox(ctr, data->key, out);
+    data->block++;
+    for(unsigned l = 0; l < 4; l++){
+      u[4*j + l] = (out[l] + 0.5) * (1./4294967296.);
+    }
+  }
+  for(unsigned j = 0; j < num; j += 2){
+    double r = sqrt(-2.*log(u[j]));
+    z[j] = r*cos(SDE_TWO_PI*u[j + 1]);
+    z[j + 1] = r*sin(SDE_TWO_PI*u[j + 1]);
+  }
+}
+
+static void SDEEulerMaruyamaStep(sde_data *data){
+  unsigned n = data->eq_num;
+  double a[n], b[n], z[n + 1];
+  double sh = sqrt(data->h);
+  SDENormals(data, z, n + n % 2);
+  data->drift(data->x, data->y, a, data->userdata);
+  data->diffusion(data->x, data->y, b, data->userdata);
+  for(unsigned i = 0; i < n; i++){
+    double dw = sh*z[i];
+    data->y[i] += a[i]*data->h + b[i]*dw;
+    data->w[i] += dw;
+  }
+}
+
+/* Derivative free Milstein: b b' is replaced by the difference quotient
+ * of b between y and the support value y + a h + b sqrt(h). */
+static void SDEMilsteinStep(sde_data *data){
+  unsigned n = data->eq_num;
+  double a[n], b[n], bs[n], ys[n], z[n + 1];
+  double sh = sqrt(data->h);
+  SDENormals(data, z, n + n % 2);
+  data->drift(data->x, data->y, a, data->userdata);
+  data->diffusion(data->x, data->y, b, data->userdata);
+  for(unsigned i = 0; i < n; i++){
+    ys[i] = data->y[i] + a[i]*data->h + b[i]*sh;
+  }
+  data->diffusion(data->x, ys, bs, data->userdata);
+  for(unsigned i = 0; i < n; i++){
+    double dw = sh*z[i];
+    data->y[i] += a[i]*data->h + b[i]*dw +
+                  (bs[i] - b[i])*(dw*dw - data->h)/(2.*sh);
+    data->w[i] += dw;
+  }
+}
+
+/* SRA1 of Roessler (2010) for additive noise. The iterated integral
+ * I10 = int int dW ds is drawn exactly together with dW from two
+ * normals per component. */
+static void SDESRA1Step(sde_data *data){
+  unsigned n = data->eq_num;
+  double a1[n], a2[n], b0[n], b1[n], h2[n], z[2*n];
+  double h = data->h;
+  double sh = sqrt(h);
+  SDENormals(data, z, 2*n);
+  data->drift(data->x, data->y, a1, data->userdata);
+  data->diffusion(data->x, data->y, b0, data->userdata);
+  data->diffusion(data->x + h, data->y, b1, data->userdata);
+  for(unsigned i = 0; i < n; i++){
+    double i10 = 0.5*h*sh*(z[2*i] + z[2*i + 1]/sqrt(3.));
+    h2[i] = data->y[i] + 0.75*a1[i]*h + 1.5*b1[i]*i10/h;
+  }
+  data->drift(data->x + 0.75*h, h2, a2, data->userdata);
+  for(unsigned i = 0; i < n; i++){
+    double dw = sh*z[2*i];
+    double i10 = 0.5*h*sh*(z[2*i] + z[2*i + 1]/sqrt(3.));
+    data->y[i] += h*(a1[i] + 2.*a2[i])/3. + b1[i]*(dw - i10/h) +
+                  b0[i]*i10/h;
+    data->w[i] += dw;
+  }
+}
+
+void SDEStep(sde_data *data){
+  switch(data->method){
+  case SDE_MILSTEIN:
+    SDEMilsteinStep(data);
+    break;
+  case SDE_SRA1:
+    SDESRA1Step(data);
+    break;
+  default:
+    SDEEulerMaruyamaStep(data);
+  }
+  data->x += data->h;
+}
+
+void SDEStepN(sde_data *data, unsigned const n){
+  for(unsigned i = 0; i < n; i++){
+    SDEStep(data);
+  }
+}
+
+double SDEGetY(sde_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->y[num];
+}
+
+double *SDEGetYs(sde_data *data){
+  if(data){
+    return data->y;
+  }
+  return NULL;
+}
+
+double SDEGetX(sde_data *data){
+  if(data){
+    return data->x;
+  }
+  return 0.;
+}
+
+double SDEGetW(sde_data *data, unsigned const num){
+  if(!data || num >= data->eq_num){
+    return 0.;
+  }
+  return data->w[num];
+}
+
+int SDESetUserData(sde_data *data, void *userdata){
+  if(data){
+    data->userdata = userdata;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "float.h"
+#include "sens.h"
+
+/* Forward sensitivities as an augmented system Z = [y, S] with the
+ * N x P matrix S = dy/dp stored column-major after y. Any solver
+ * integrates Z through its system right side, so the sensitivity
+ * columns go through exactly the stages of the primal solve.
+ * Without a user Jacobian-vector product every column costs one extra
+ * right side evaluation in the direction (S_j, e_j). */
+
+struct sens_data_st{
+  unsigned eq_num;
+  unsigned param_num;
+  double *params;
+  double *ytmp;
+  double *ftmp;
+  SensSysFunc sys;
+  SensJVPFunc jvp;
+  void *userdata;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+int SensInitData(sens_data **data, unsigned const eq_num,
+                 unsigned const param_num){
+  *data = calloc(1, sizeof(sens_data));
+  EXIT_IF_NULL(*data);
+  (*data)->eq_num = eq_num;
+  (*data)->param_num = param_num;
+  (*data)->ytmp = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->ytmp);
+  (*data)->ftmp = calloc(eq_num, sizeof(double));
+  EXIT_IF_NULL((*data)->ftmp);
+  return 1;
+error:
+  if(*data){
+    free((*data)->ytmp);
+    free(*data);
+    *data = NULL;
+  }
+  return 0;
+}
+
+void SensFreeData(sens_data *data){
+  if(data){
+    free(data->ftmp);
+    free(data->ytmp);
+    free(data);
+  }
+}
+
+int SensSetSystem(sens_data *data, SensSysFunc func){
+  if(!data){
+    return 0;
+  }
+  data->sys = func;
+  return 1;
+}
+
+int SensSetJVP(sens_data *data, SensJVPFunc func){
+  if(!data){
+    return 0;
+  }
+  data->jvp = func;
+  return 1;
+}
+
+int SensSetParams(sens_data *data, double *params){
+  if(!data){
+    return 0;
+  }
+  data->params = params;
+  return 1;
+}
+
+int SensSetUserData(sens_data *data, void *userdata){
+  if(data){
+    data->userdata = userdata;
+    return 1;
+  }
+  return 0;
+}
+
+int SensCheck(sens_data *data){
+  if(!data || !data->eq_num){
+    fprintf(stderr, "%s\n", "SensCheck: Incorrect initialization.");
+    return 0;
+  }
+  if(!data->sys){
+    fprintf(stderr, "%s\n", "SensCheck: Right side function not assigned.");
+    return 0;
+  }
+  if(!data->jvp && data->param_num && !data->params){
+    fprintf(stderr, "%s\n", "SensCheck: Finite differences need the parameter array.");
+    return 0;
+  }
+  return 1;
+}
+
+unsigned SensGetSize(sens_data *data){
+  if(data){
+    return data->eq_num*(data->param_num + 1);
+  }
+  return 0;
+}
+
+int SensInitState(sens_data *data, double const ys[], double const ss[],
+                  double *Z){
+  if(!data || !ys || !Z){
+    return 0;
+  }
+  unsigned ns = data->eq_num*data->param_num;
+  memcpy(Z, ys, sizeof(double)*data->eq_num);
+  if(ss){
+    memcpy(Z + data->eq_num, ss, sizeof(double)*ns);
+  } else {
+    memset(Z + data->eq_num, 0, sizeof(double)*ns);
+  }
+  return 1;
+}
+
+void SensRightSide(double const x, double const *Z, double *DZ,
+                   void *userdata){
+  sens_data *data = userdata;
+  unsigned const n = data->eq_num;
+  double const *y = Z;
+  data->sys(x, y, DZ, data->userdata);
+  if(data->jvp){
+    for(unsigned j = 0; j < data->param_num; j++){
+      data->jvp(x, y, Z + n*(j + 1), j, DZ + n*(j + 1), data->userdata);
+    }
+    return;
+  }
+  double ynorm = 0.;
+  for(unsigned i = 0; i < n; i++){
+    ynorm += y[i]*y[i];
+  }
+  for(unsigned j = 0; j < data->param_num; j++){
+    double const *s = Z + n*(j + 1);
+    double *ds = DZ + n*(j + 1);
+    double snorm = 1.;
+    for(unsigned i = 0; i < n; i++){
+      snorm += s[i]*s[i];
+    }
+    double p = data->params[j];
+    double eps = sqrt(DBL_EPSILON)*(1. + sqrt(ynorm + p*p))/sqrt(snorm);
+    for(unsigned i = 0; i < n; i++){
+      data->ytmp[i] = y[i] + eps*s[i];
+    }
+    data->params[j] = p + eps;
+    data->sys(x, data->ytmp, data->ftmp, data->userdata);
+    data->params[j] = p;
+    for(unsigned i = 0; i < n; i++){
+      ds[i] = (data->ftmp[i] - DZ[i])/eps;
+    }
+  }
+}
+
+double SensGetS(sens_data *data, double const *Z, unsigned const eq,
+                unsigned const param){
+  if(!data || !Z || eq >= data->eq_num || param >= data->param_num){
+    return 0.;
+  }
+  return Z[data->eq_num*(param + 1) + eq];
+}
+
+double const *SensGetSs(sens_data *data, double const *Z){
+  if(data && Z){
+    return Z + data->eq_num;
+  }
+  return NULL;
+}
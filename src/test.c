@@ -1,6 +1,29 @@
+#define _GNU_SOURCE
 #include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
 #include "adams.h"
 #include "adams5.h"
+#include "parareal.h"
+#include "gbs.h"
+#include "observer.h"
+#include "sens.h"
+#include "dde.h"
+#include "rkn.h"
+#include "sde.h"
+#include "linear.h"
+#include "etd.h"
+#include "rkc.h"
+#include "runner.h"
+#include "forcing.h"
+#include "crk4.h"
+#include "crk5.h"
+#include "traj.h"
+#include "autotune.h"
 #include "rk4.h"
 #include "rk5.h"
 
@@ -26,6 +49,11 @@ double RightSideX(double const x, double const *y, void *userdata){
   return y[V];
 }
 
+void RightSide(double const x, double const *y, double *dy, void *userdata){
+  dy[V] = RightSideV(x, y, userdata);
+  dy[X] = RightSideX(x, y, userdata);
+}
+
 int TestAdams(void){
   FILE * a_res = fopen("adams.txt", "w");
   a_data *adams_data;
@@ -154,6 +182,1235 @@ error:
   return 0;
 }
 
+enum MR_VAL_NAME {MR_V, MR_X, MR_S, MR_EQUATIONS_NUM};
+
+double RightSideSlow(double const x, double const *y, void *userdata){
+  return -0.5*y[MR_S] + 0.01*y[MR_X];
+}
+
+int TestRK4Multirate(void){
+  FILE *rkres = fopen("rk4_multirate.txt", "w");
+  rk_data *fine, *mr;
+  EXIT_IF_0(RK4InitData(&fine, MR_EQUATIONS_NUM));
+  EXIT_IF_0(RK4InitData(&mr, MR_EQUATIONS_NUM));
+  double vals[MR_EQUATIONS_NUM];
+  vals[MR_V] = 1.;
+  vals[MR_X] = 0.;
+  vals[MR_S] = 1.;
+  struct user_data udata = {1000., 1.};
+  RK4RSFunc funcs[MR_EQUATIONS_NUM] = {RightSideV, RightSideX, RightSideSlow};
+  EXIT_IF_0(RK4SetYs0(fine, vals, MR_EQUATIONS_NUM));
+  EXIT_IF_0(RK4SetYs0(mr, vals, MR_EQUATIONS_NUM));
+  EXIT_IF_0(RK4SetEquations(fine, funcs, MR_EQUATIONS_NUM));
+  EXIT_IF_0(RK4SetEquations(mr, funcs, MR_EQUATIONS_NUM));
+  EXIT_IF_0(RK4SetEquationRate(mr, RK4_RATE_FAST, MR_V));
+  EXIT_IF_0(RK4SetEquationRate(mr, RK4_RATE_FAST, MR_X));
+  EXIT_IF_0(RK4SetUserData(fine, &udata));
+  EXIT_IF_0(RK4SetUserData(mr, &udata));
+  EXIT_IF_0(RK4SetStep(fine, STEP));
+  EXIT_IF_0(RK4SetStep(mr, 10*STEP));
+  EXIT_IF_0(RK4SetSubsteps(mr, 10));
+  EXIT_IF_0(RK4Check(fine));
+  EXIT_IF_0(RK4Check(mr));
+  double t;
+  do{
+    RK4Step(mr);
+    for(int i = 0; i < 10; i++){
+      RK4Step(fine);
+    }
+    t = RK4GetX(mr);
+    fprintf(rkres, "%.12g\t%.12g\t%.12g\t%.12g\n",
+            t,
+            RK4GetY(mr, MR_X),
+            RK4GetY(mr, MR_S),
+            RK4GetY(mr, MR_S) - RK4GetY(fine, MR_S));
+  }while(t <= 20.);
+  EXIT_IF_0(fabs(RK4GetY(mr, MR_S) - RK4GetY(fine, MR_S)) < 1.E-6);
+  EXIT_IF_0(fabs(RK4GetY(mr, MR_X) - RK4GetY(fine, MR_X)) < 1.E-6);
+  RK4FreeData(fine);
+  RK4FreeData(mr);
+  fclose(rkres);
+  return 1;
+error:
+  fclose(rkres);
+  return 0;
+}
+
+int TestParareal(void){
+  FILE *prres = fopen("parareal.txt", "w");
+  pr_data *data;
+  rk5_data *serial;
+  EXIT_IF_0(PararealInitData(&data, EQUATIONS_NUM, 16));
+  EXIT_IF_0(RK5InitData(&serial, EQUATIONS_NUM));
+  double vals[EQUATIONS_NUM];
+  vals[V] = 1.;
+  vals[X] = 0.;
+  struct user_data udata = {10., 1.};
+  EXIT_IF_0(PararealSetYs0(data, vals, EQUATIONS_NUM));
+  EXIT_IF_0(PararealSetX(data, 0.));
+  EXIT_IF_0(PararealSetXEnd(data, 20.));
+  EXIT_IF_0(PararealSetEquation(data, RightSideV, V));
+  EXIT_IF_0(PararealSetEquation(data, RightSideX, X));
+  EXIT_IF_0(PararealSetUserData(data, &udata));
+  EXIT_IF_0(PararealSetCoarseStep(data, 0.1));
+  EXIT_IF_0(PararealSetFineStep(data, STEP));
+  EXIT_IF_0(PararealSetTolerance(data, 1.E-10));
+  EXIT_IF_0(PararealSetThreads(data, 4));
+  EXIT_IF_0(PararealCheck(data));
+  EXIT_IF_0(PararealSolve(data));
+  EXIT_IF_0(RK5SetYs0(serial, vals, EQUATIONS_NUM));
+  EXIT_IF_0(RK5SetX(serial, 0.));
+  EXIT_IF_0(RK5SetEquation(serial, RightSideV, V));
+  EXIT_IF_0(RK5SetEquation(serial, RightSideX, X));
+  EXIT_IF_0(RK5SetUserData(serial, &udata));
+  EXIT_IF_0(RK5SetStep(serial, STEP));
+  for(int i = 0; i < 20000; i++){
+    RK5Step(serial);
+  }
+  for(unsigned s = 0; s <= 16; s++){
+    fprintf(prres, "%.12g\t%.12g\t%.12g\n",
+            20.*s/16,
+            PararealGetSliceYs(data, s)[X],
+            PararealGetSliceYs(data, s)[V]);
+  }
+  fprintf(prres, "# iterations %u speedup %.3g\n",
+          PararealGetIterations(data), PararealGetSpeedup(data));
+  EXIT_IF_0(PararealIsConverged(data));
+  EXIT_IF_0(fabs(PararealGetY(data, X) - RK5GetY(serial, X)) < 1.E-8);
+  RK5FreeData(serial);
+  PararealFreeData(data);
+  fclose(prres);
+  return 1;
+error:
+  fclose(prres);
+  return 0;
+}
+
+double RightSideNaN(double const x, double const *y, void *userdata){
+  return NAN;
+}
+
+int TestGBS(void){
+  FILE *gbsres = fopen("gbs.txt", "w");
+  gbs_data *data;
+  EXIT_IF_0(GBSInitData(&data, EQUATIONS_NUM));
+  double vals[EQUATIONS_NUM];
+  vals[V] = 1.;
+  vals[X] = 0.;
+  struct user_data udata = {10., 1.};
+  double w = sqrt(udata.k/udata.m);
+  EXIT_IF_0(GBSSetYs0(data, vals, EQUATIONS_NUM));
+  EXIT_IF_0(GBSSetX(data, 0.));
+  EXIT_IF_0(GBSSetEquation(data, RightSideV, V));
+  EXIT_IF_0(GBSSetEquation(data, RightSideX, X));
+  EXIT_IF_0(GBSSetUserData(data, &udata));
+  EXIT_IF_0(GBSSetStep(data, 0.1));
+  EXIT_IF_0(GBSSetTolerance(data, 1.E-12, 1.E-12));
+  EXIT_IF_0(GBSSetThreads(data, 4));
+  EXIT_IF_0(GBSCheck(data));
+  double t;
+  do{
+    EXIT_IF_0(GBSIntegrate(data, GBSGetX(data) + 0.5));
+    t = GBSGetX(data);
+    fprintf(gbsres, "%.12g\t%.12g\t%.12g\t%u\n",
+            t,
+            GBSGetY(data, X),
+            GBSGetY(data, V),
+            GBSGetOrder(data));
+  }while(t < 20.);
+  EXIT_IF_0(fabs(GBSGetY(data, X) - sin(w*t)/w) < 1.E-9);
+  EXIT_IF_0(fabs(GBSGetY(data, V) - cos(w*t)) < 1.E-9);
+  /* a right side going NaN must fail the step, not loop */
+  EXIT_IF_0(GBSSetEquation(data, RightSideNaN, V));
+  EXIT_IF_0(!GBSStep(data));
+  EXIT_IF_0(GBSGetX(data) == t);
+  GBSFreeData(data);
+  fclose(gbsres);
+  return 1;
+error:
+  fclose(gbsres);
+  return 0;
+}
+
+int TestObserver(void){
+  FILE *rkres = fopen("rk4_observer.txt", "w");
+  rk_data *rk4_data;
+  obs_data *obs;
+  EXIT_IF_0(RK4InitData(&rk4_data, EQUATIONS_NUM));
+  EXIT_IF_0(ObserverInitData(&obs, EQUATIONS_NUM, 1024));
+  double vals[EQUATIONS_NUM];
+  vals[V] = 1.;
+  vals[X] = 0.;
+  struct user_data udata = {10., 1.};
+  EXIT_IF_0(RK4SetYs0(rk4_data, vals, EQUATIONS_NUM));
+  EXIT_IF_0(RK4SetX(rk4_data, 0.));
+  EXIT_IF_0(RK4SetEquation(rk4_data, RightSideV, V));
+  EXIT_IF_0(RK4SetEquation(rk4_data, RightSideX, X));
+  EXIT_IF_0(RK4SetUserData(rk4_data, &udata));
+  EXIT_IF_0(RK4SetStep(rk4_data, STEP));
+  EXIT_IF_0(RK4Check(rk4_data));
+  EXIT_IF_0(ObserverSetOutput(obs, rkres));
+  EXIT_IF_0(ObserverSetPolicy(obs, OBSERVER_BLOCK));
+  EXIT_IF_0(ObserverStart(obs));
+  unsigned long steps = 0;
+  double t;
+  do{
+    RK4Step(rk4_data);
+    t = RK4GetX(rk4_data);
+    EXIT_IF_0(ObserverPush(obs, t, RK4GetYs(rk4_data)) == 1);
+    steps++;
+  }while(t <= 20.);
+  EXIT_IF_0(ObserverStop(obs));
+  EXIT_IF_0(ObserverGetWritten(obs) == steps);
+  EXIT_IF_0(ObserverPush(obs, t, RK4GetYs(rk4_data)) == -1);
+  EXIT_IF_0(ObserverPush(NULL, t, RK4GetYs(rk4_data)) == -1);
+  ObserverFreeData(obs);
+  RK4FreeData(rk4_data);
+  fclose(rkres);
+  return 1;
+error:
+  fclose(rkres);
+  return 0;
+}
+
+#define OBSERVER_CAP 16
+#define OBSERVER_PUSHES 100
+
+/* Holding the stream lock stalls the consumer in its first write, so
+ * the ring fills after exactly OBSERVER_CAP records. */
+int TestObserverPolicies(void){
+  FILE *out = fopen("observer_policy.txt", "w");
+  obs_data *obs = NULL;
+  struct timespec pause = {0, 100000};
+  double ys[EQUATIONS_NUM] = {0., 0.};
+  unsigned long queued = 0;
+  int locked = 0;
+  EXIT_IF_0(out);
+  EXIT_IF_0(ObserverInitData(&obs, EQUATIONS_NUM, OBSERVER_CAP));
+  EXIT_IF_0(ObserverSetOutput(obs, out));
+  EXIT_IF_0(ObserverSetPolicy(obs, OBSERVER_DROP));
+  flockfile(out);
+  locked = 1;
+  EXIT_IF_0(ObserverStart(obs));
+  for(unsigned i = 0; i < OBSERVER_PUSHES; i++){
+    int res = ObserverPush(obs, i, ys);
+    EXIT_IF_0(res == (i < OBSERVER_CAP));
+  }
+  funlockfile(out);
+  locked = 0;
+  EXIT_IF_0(ObserverStop(obs));
+  EXIT_IF_0(ObserverGetWritten(obs) == OBSERVER_CAP);
+  EXIT_IF_0(ObserverGetDropped(obs) == OBSERVER_PUSHES - OBSERVER_CAP);
+  /* decimation doubles on every full push and backs off once the
+   * consumer has caught up */
+  EXIT_IF_0(ObserverSetPolicy(obs, OBSERVER_DECIMATE));
+  flockfile(out);
+  locked = 1;
+  EXIT_IF_0(ObserverStart(obs));
+  for(unsigned i = 0; i < OBSERVER_PUSHES; i++){
+    int res = ObserverPush(obs, i, ys);
+    EXIT_IF_0(res >= 0);
+    queued += res;
+  }
+  funlockfile(out);
+  locked = 0;
+  EXIT_IF_0(queued == OBSERVER_CAP);
+  EXIT_IF_0(ObserverGetDropped(obs) < OBSERVER_PUSHES - OBSERVER_CAP);
+  unsigned last = 0;
+  for(unsigned i = 0; i < 200; i++){
+    nanosleep(&pause, NULL);
+    int res = ObserverPush(obs, i, ys);
+    EXIT_IF_0(res >= 0);
+    queued += res;
+    last = res ? last + 1 : 0;
+  }
+  EXIT_IF_0(last >= 20);
+  EXIT_IF_0(ObserverStop(obs));
+  EXIT_IF_0(ObserverGetWritten(obs) == queued);
+  ObserverFreeData(obs);
+  fclose(out);
+  return 1;
+error:
+  if(locked){
+    funlockfile(out);
+  }
+  ObserverFreeData(obs);
+  if(out){
+    fclose(out);
+  }
+  return 0;
+}
+
+int TestSystem(void){
+  rk_data *rk4, *rk4s;
+  a5_data *a5, *a5s;
+  EXIT_IF_0(RK4InitData(&rk4, EQUATIONS_NUM));
+  EXIT_IF_0(RK4InitData(&rk4s, EQUATIONS_NUM));
+  EXIT_IF_0(Adams5InitData(&a5, EQUATIONS_NUM));
+  EXIT_IF_0(Adams5InitData(&a5s, EQUATIONS_NUM));
+  double vals[EQUATIONS_NUM];
+  vals[V] = 1.;
+  vals[X] = 0.;
+  struct user_data udata = {10., 1.};
+  EXIT_IF_0(RK4SetYs0(rk4, vals, EQUATIONS_NUM));
+  EXIT_IF_0(RK4SetYs0(rk4s, vals, EQUATIONS_NUM));
+  EXIT_IF_0(Adams5SetYs0(a5, vals, EQUATIONS_NUM));
+  EXIT_IF_0(Adams5SetYs0(a5s, vals, EQUATIONS_NUM));
+  EXIT_IF_0(RK4SetEquation(rk4, RightSideV, V));
+  EXIT_IF_0(RK4SetEquation(rk4, RightSideX, X));
+  EXIT_IF_0(RK4SetSystem(rk4s, RightSide));
+  EXIT_IF_0(Adams5SetEquation(a5, RightSideV, V));
+  EXIT_IF_0(Adams5SetEquation(a5, RightSideX, X));
+  EXIT_IF_0(Adams5SetSystem(a5s, RightSide));
+  EXIT_IF_0(RK4SetUserData(rk4, &udata));
+  EXIT_IF_0(RK4SetUserData(rk4s, &udata));
+  EXIT_IF_0(Adams5SetUserData(a5, &udata));
+  EXIT_IF_0(Adams5SetUserData(a5s, &udata));
+  EXIT_IF_0(RK4SetStep(rk4, STEP));
+  EXIT_IF_0(RK4SetStep(rk4s, STEP));
+  EXIT_IF_0(Adams5SetStep(a5, STEP));
+  EXIT_IF_0(Adams5SetStep(a5s, STEP));
+  EXIT_IF_0(RK4Check(rk4s));
+  EXIT_IF_0(Adams5Check(a5s));
+  for(int i = 0; i < 20000; i++){
+    RK4Step(rk4);
+    Adams5Step(a5);
+  }
+  RK4StepN(rk4s, 20000);
+  Adams5StepN(a5s, 20000);
+  for(int i = 0; i < EQUATIONS_NUM; i++){
+    EXIT_IF_0(RK4GetY(rk4, i) == RK4GetYs(rk4s)[i]);
+    EXIT_IF_0(RK4GetDY(rk4, i) == RK4GetDYs(rk4s)[i]);
+    EXIT_IF_0(Adams5GetY(a5, i) == Adams5GetYs(a5s)[i]);
+  }
+  RK4FreeData(rk4);
+  RK4FreeData(rk4s);
+  Adams5FreeData(a5);
+  Adams5FreeData(a5s);
+  return 1;
+error:
+  return 0;
+}
+
+struct decay_data{
+  double p[2]; //decay rate, inflow
+};
+
+void RightSideDecay(double const x, double const *y, double *dy,
+                    void *userdata){
+  struct decay_data *data = userdata;
+  dy[0] = -data->p[0]*y[0] + data->p[1];
+}
+
+void JVPDecay(double const x, double const *y, double const *s,
+              unsigned const param, double *ds, void *userdata){
+  struct decay_data *data = userdata;
+  ds[0] = -data->p[0]*s[0] + (param ? 1. : -y[0]);
+}
+
+int TestSens(void){
+  FILE *sres = fopen("sens.txt", "w");
+  struct decay_data udata = {{2., 3.}};
+  sens_data *fd, *jvp;
+  rk_data *rk4;
+  a_data *adams;
+  EXIT_IF_0(SensInitData(&fd, 1, 2));
+  EXIT_IF_0(SensInitData(&jvp, 1, 2));
+  EXIT_IF_0(SensSetSystem(fd, RightSideDecay));
+  EXIT_IF_0(SensSetSystem(jvp, RightSideDecay));
+  EXIT_IF_0(SensSetParams(fd, udata.p));
+  EXIT_IF_0(SensSetJVP(jvp, JVPDecay));
+  EXIT_IF_0(SensSetUserData(fd, &udata));
+  EXIT_IF_0(SensSetUserData(jvp, &udata));
+  EXIT_IF_0(SensCheck(fd));
+  EXIT_IF_0(SensCheck(jvp));
+  double y0 = 1.;
+  double z[3];
+  EXIT_IF_0(RK4InitData(&rk4, SensGetSize(fd)));
+  EXIT_IF_0(AdamsInitData(&adams, SensGetSize(jvp)));
+  EXIT_IF_0(SensInitState(fd, &y0, NULL, z));
+  EXIT_IF_0(RK4SetYs0(rk4, z, SensGetSize(fd)));
+  EXIT_IF_0(AdamsSetYs0(adams, z, SensGetSize(jvp)));
+  EXIT_IF_0(RK4SetSystem(rk4, SensRightSide));
+  EXIT_IF_0(AdamsSetSystem(adams, SensRightSide));
+  EXIT_IF_0(RK4SetUserData(rk4, fd));
+  EXIT_IF_0(AdamsSetUserData(adams, jvp));
+  EXIT_IF_0(RK4SetStep(rk4, STEP));
+  EXIT_IF_0(AdamsSetStep(adams, STEP));
+  EXIT_IF_0(RK4Check(rk4));
+  EXIT_IF_0(AdamsCheck(adams));
+  RK4StepN(rk4, 2000);
+  AdamsStepN(adams, 2000);
+  double t = RK4GetX(rk4);
+  double a = udata.p[0], b = udata.p[1], e = exp(-a*t);
+  double s[2] = {-b/(a*a)*(1. - e) - (1. - b/a)*t*e, (1. - e)/a};
+  for(unsigned j = 0; j < 2; j++){
+    fprintf(sres, "%.12g\t%.12g\t%.12g\n", s[j],
+            SensGetS(fd, RK4GetYs(rk4), 0, j),
+            SensGetS(jvp, AdamsGetYs(adams), 0, j));
+    EXIT_IF_0(fabs(SensGetS(fd, RK4GetYs(rk4), 0, j) - s[j]) < 1.E-7);
+    EXIT_IF_0(fabs(SensGetS(jvp, AdamsGetYs(adams), 0, j) - s[j]) < 1.E-7);
+  }
+  RK4FreeData(rk4);
+  AdamsFreeData(adams);
+  SensFreeData(fd);
+  SensFreeData(jvp);
+  fclose(sres);
+  return 1;
+error:
+  fclose(sres);
+  return 0;
+}
+
+double RightSideDelay(double const x, double const *y, double const *yd,
+                      void *userdata){
+  return -yd[0];
+}
+
+double RightSideStateDelay(double const x, double const *y,
+                           double const *yd, void *userdata){
+  dde_data **data = userdata;
+  return -DDEGetDelayed(*data, x - 1., 1);
+}
+
+double HistoryDelay(double const x, unsigned const index, void *userdata){
+  return 1.;
+}
+
+#define DDE_PI 3.14159265358979323846
+
+/* Bitwise, since -ffast-math folds isnan() and v != v. */
+int IsNaN(double const v){
+  unsigned long long bits;
+  memcpy(&bits, &v, sizeof(bits));
+  return (bits >> 52 & 0x7FF) == 0x7FF && (bits << 12);
+}
+
+/* y' = -y(x - pi/2)/2 + y(x - 3pi/2)/2 with y = sin x as history and
+ * solution; the delays are 150 steps apart. */
+double RightSideTwoDelays(double const x, double const *y, double const *yd,
+                          void *userdata){
+  return -0.5*yd[0] + 0.5*yd[1];
+}
+
+double HistorySin(double const x, unsigned const index, void *userdata){
+  return sin(x);
+}
+
+int TestDDEDelays(void){
+  dde_data *data = NULL;
+  EXIT_IF_0(DDEInitData(&data, 1, 2, 1.5*DDE_PI));
+  EXIT_IF_0(DDESetY0(data, 0., 0));
+  EXIT_IF_0(DDESetX(data, 0.));
+  EXIT_IF_0(DDESetDelay(data, 0.5*DDE_PI, 0));
+  EXIT_IF_0(DDESetDelay(data, 1.5*DDE_PI, 1));
+  EXIT_IF_0(DDESetHistory(data, HistorySin));
+  EXIT_IF_0(DDESetEquation(data, RightSideTwoDelays, 0));
+  EXIT_IF_0(DDESetStep(data, 0.01*DDE_PI));
+  EXIT_IF_0(DDECheck(data));
+  for(unsigned i = 0; i < 1000; i++){
+    DDEStep(data);
+    /* a state dependent lookup between the two delays */
+    double t = DDEGetX(data) - DDE_PI;
+    EXIT_IF_0(fabs(DDEGetDelayed(data, t, 0) - sin(t)) < 1.E-6);
+  }
+  EXIT_IF_0(fabs(DDEGetY(data, 0) - sin(DDEGetX(data))) < 1.E-6);
+  /* the past beyond max_delay is gone and must not be extrapolated */
+  double old = DDEGetDelayed(data, DDEGetX(data) - 3.*DDE_PI, 0);
+  EXIT_IF_0(IsNaN(old));
+  DDEFreeData(data);
+  return 1;
+error:
+  DDEFreeData(data);
+  return 0;
+}
+
+int TestDDE(void){
+  FILE *dres = fopen("dde.txt", "w");
+  dde_data *data;
+  double const steps[] = {0.01, 0.03};
+  for(unsigned m = 0; m < 4; m++){
+    EXIT_IF_0(DDEInitData(&data, 2, 1, 1.));
+    EXIT_IF_0(DDESetMethod(data, m/2 ? DDE_RK5 : DDE_RK4));
+    EXIT_IF_0(DDESetY0(data, 1., 0));
+    EXIT_IF_0(DDESetY0(data, 1., 1));
+    EXIT_IF_0(DDESetX(data, 0.));
+    EXIT_IF_0(DDESetDelay(data, 1., 0));
+    EXIT_IF_0(DDESetHistory(data, HistoryDelay));
+    EXIT_IF_0(DDESetEquation(data, RightSideDelay, 0));
+    EXIT_IF_0(DDESetEquation(data, RightSideStateDelay, 1));
+    EXIT_IF_0(DDESetUserData(data, &data));
+    EXIT_IF_0(DDESetStep(data, steps[m%2]));
+    EXIT_IF_0(DDECheck(data));
+    for(int i = 0; i < 3./steps[m%2] - 0.5; i++){
+      DDEStep(data);
+    }
+    fprintf(dres, "%.12g\t%.12g\t%.12g\n",
+            DDEGetX(data), DDEGetY(data, 0), DDEGetY(data, 1));
+    EXIT_IF_0(fabs(DDEGetY(data, 0) + 1./6.) < 1.E-6);
+    EXIT_IF_0(fabs(DDEGetY(data, 1) + 1./6.) < 1.E-6);
+    DDEFreeData(data);
+  }
+  fclose(dres);
+  return 1;
+error:
+  fclose(dres);
+  return 0;
+}
+
+double RightSideSpring(double const x, double const *y, void *userdata){
+  struct user_data *data = userdata;
+  return -data->k / data->m * y[0]; //Hooke's law
+}
+
+int TestRKN(void){
+  FILE *rkres = fopen("rkn.txt", "w");
+  rkn_data *data;
+  struct user_data udata = {10., 1.};
+  double w = sqrt(udata.k/udata.m);
+  for(int m = 0; m < 2; m++){
+    EXIT_IF_0(RKNInitData(&data, 1));
+    EXIT_IF_0(RKNSetMethod(data, m ? RKN_5 : RKN_4));
+    EXIT_IF_0(RKNSetY0(data, 0., 0));
+    EXIT_IF_0(RKNSetDY0(data, 1., 0));
+    EXIT_IF_0(RKNSetX(data, 0.));
+    EXIT_IF_0(RKNSetEquation(data, RightSideSpring, 0));
+    EXIT_IF_0(RKNSetUserData(data, &udata));
+    EXIT_IF_0(RKNSetStep(data, m ? 0.01 : STEP));
+    EXIT_IF_0(RKNSetTolerance(data, m ? 1.E-10 : 0., m ? 1.E-10 : 0.));
+    EXIT_IF_0(RKNCheck(data));
+    double t;
+    do{
+      EXIT_IF_0(RKNStep(data));
+      t = RKNGetX(data);
+      fprintf(rkres, "%.12g\t%.12g\t%.12g\n",
+              t,
+              RKNGetY(data, 0),
+              RKNGetDY(data, 0));
+    }while(t <= 20.);
+    EXIT_IF_0(fabs(RKNGetY(data, 0) - sin(w*t)/w) < 1.E-8);
+    EXIT_IF_0(fabs(RKNGetDY(data, 0) - cos(w*t)) < 1.E-8);
+    if(m){
+      /* a right side going NaN must fail the step, not loop */
+      double h = RKNGetStep(data);
+      EXIT_IF_0(RKNSetEquation(data, RightSideNaN, 0));
+      EXIT_IF_0(!RKNStepN(data, 10));
+      EXIT_IF_0(RKNGetX(data) == t && RKNGetStep(data) == h);
+    }
+    RKNFreeData(data);
+  }
+  fclose(rkres);
+  return 1;
+error:
+  fclose(rkres);
+  return 0;
+}
+
+#define CHAIN_NUM 8192
+
+/* Diffusion along a chain of masses, written for row ranges. */
+void RightSideChain(double const x, double const *y, double *dy,
+                    unsigned const first, unsigned const last,
+                    void *userdata){
+  for(unsigned i = first; i < last; i++){
+    double l = i ? y[i - 1] : 0.;
+    double r = i + 1 < CHAIN_NUM ? y[i + 1] : 0.;
+    dy[i] = l - 2.*y[i] + r;
+  }
+}
+
+int TestRK4Threads(void){
+  rk_data *serial = NULL, *threaded = NULL;
+  pool_data *pool = NULL;
+  double ys[CHAIN_NUM];
+  for(unsigned i = 0; i < CHAIN_NUM; i++){
+    ys[i] = sin(0.01*i);
+  }
+  EXIT_IF_0(PoolInitData(&pool, 4));
+  EXIT_IF_0(RK4InitData(&serial, CHAIN_NUM));
+  EXIT_IF_0(RK4InitData(&threaded, CHAIN_NUM));
+  EXIT_IF_0(RK4SetPool(threaded, pool));
+  EXIT_IF_0(RK4SetYs0(serial, ys, CHAIN_NUM));
+  EXIT_IF_0(RK4SetYs0(threaded, ys, CHAIN_NUM));
+  EXIT_IF_0(RK4SetRangeSystem(serial, RightSideChain));
+  EXIT_IF_0(RK4SetRangeSystem(threaded, RightSideChain));
+  EXIT_IF_0(RK4SetStep(serial, 0.1));
+  EXIT_IF_0(RK4SetStep(threaded, 0.1));
+  EXIT_IF_0(RK4Check(serial));
+  EXIT_IF_0(RK4Check(threaded));
+  RK4StepN(serial, 100);
+  RK4StepN(threaded, 100);
+  EXIT_IF_0(RK4GetX(serial) == RK4GetX(threaded));
+  for(unsigned i = 0; i < CHAIN_NUM; i++){
+    EXIT_IF_0(RK4GetY(serial, i) == RK4GetY(threaded, i));
+    EXIT_IF_0(RK4GetDY(serial, i) == RK4GetDY(threaded, i));
+  }
+  /* detached, the solver must not touch the pool any more */
+  EXIT_IF_0(RK4SetPool(threaded, NULL));
+  PoolFreeData(pool);
+  pool = NULL;
+  RK4StepN(serial, 10);
+  RK4StepN(threaded, 10);
+  for(unsigned i = 0; i < CHAIN_NUM; i++){
+    EXIT_IF_0(RK4GetY(serial, i) == RK4GetY(threaded, i));
+  }
+  RK4FreeData(serial);
+  RK4FreeData(threaded);
+  return 1;
+error:
+  RK4FreeData(serial);
+  RK4FreeData(threaded);
+  PoolFreeData(pool);
+  return 0;
+}
+
+#define AFFINITY_THREADS 3
+
+struct affinity_data{
+  int cpus[AFFINITY_THREADS];
+  unsigned num;
+  int placed[AFFINITY_THREADS];
+};
+
+#ifdef __linux__
+/* Task t runs on thread t, which must be pinned to cpus[t % num] only. */
+void AffinityTask(unsigned const task, unsigned const thread, void *arg){
+  struct affinity_data *data = arg;
+  cpu_set_t set;
+  data->placed[thread] =
+    !pthread_getaffinity_np(pthread_self(), sizeof(set), &set) &&
+    1 == CPU_COUNT(&set) && CPU_ISSET(data->cpus[thread % data->num], &set);
+}
+#endif
+
+int TestPoolAffinity(void){
+#ifdef __linux__
+  pool_data *pool = NULL;
+  struct affinity_data data = {.num = 0};
+  cpu_set_t before, after;
+  EXIT_IF_0(!pthread_getaffinity_np(pthread_self(), sizeof(before),
+                                    &before));
+  for(int cpu = 0; cpu < CPU_SETSIZE && data.num < AFFINITY_THREADS; cpu++){
+    if(CPU_ISSET(cpu, &before)){
+      data.cpus[data.num++] = cpu;
+    }
+  }
+  EXIT_IF_0(data.num);
+  EXIT_IF_0(PoolInitData(&pool, AFFINITY_THREADS));
+  /* pinned twice: the first mask is the one restored */
+  EXIT_IF_0(PoolSetAffinity(pool, data.cpus, 1));
+  EXIT_IF_0(PoolSetAffinity(pool, data.cpus, data.num));
+  EXIT_IF_0(PoolRunStatic(pool, AffinityTask, AFFINITY_THREADS, &data));
+  for(unsigned i = 0; i < AFFINITY_THREADS; i++){
+    EXIT_IF_0(data.placed[i]);
+  }
+  PoolFreeData(pool);
+  pool = NULL;
+  EXIT_IF_0(!pthread_getaffinity_np(pthread_self(), sizeof(after), &after));
+  EXIT_IF_0(CPU_EQUAL(&before, &after));
+  return 1;
+error:
+  PoolFreeData(pool);
+  return 0;
+#else
+  return 1;
+#endif
+}
+
+struct gbm_data{
+  double mu;
+  double sigma;
+};
+
+void DriftGBM(double const x, double const *y, double *a, void *userdata){
+  struct gbm_data *data = userdata;
+  a[0] = data->mu*y[0];
+}
+
+void DiffusionGBM(double const x, double const *y, double *b,
+                  void *userdata){
+  struct gbm_data *data = userdata;
+  b[0] = data->sigma*y[0];
+}
+
+void DriftCos(double const x, double const *y, double *a, void *userdata){
+  a[0] = cos(x);
+}
+
+void DiffusionConst(double const x, double const *y, double *b,
+                    void *userdata){
+  b[0] = 0.5;
+}
+
+#define SDE_PATHS 200
+#define SDE_STEPS 64
+
+/* Mean strong error of GBM at x = 1 against the exact solution driven
+ * by the same Wiener path. */
+double StrongErrorGBM(sde_data *data, struct gbm_data *gbm){
+  double err = 0.;
+  for(unsigned p = 0; p < SDE_PATHS; p++){
+    SDESetStream(data, 42, p);
+    SDESetX(data, 0.);
+    SDESetY0(data, 1., 0);
+    SDEStepN(data, SDE_STEPS);
+    double exact = exp((gbm->mu - 0.5*gbm->sigma*gbm->sigma)*SDEGetX(data) +
+                       gbm->sigma*SDEGetW(data, 0));
+    err += fabs(SDEGetY(data, 0) - exact);
+  }
+  return err / SDE_PATHS;
+}
+
+int TestSDE(void){
+  sde_data *data = NULL;
+  struct gbm_data gbm = {1.5, 1.};
+  uint32_t ctr[4] = {0, 0, 0, 0}, key[2] = {0, 0}, out[4];
+  SDEPhilox(ctr, key, out);
+  EXIT_IF_0(out[0] == 0x6627e8d5u && out[1] == 0xe169c58du &&
+            out[2] == 0xbc57ac4cu && out[3] == 0x9b00dbd8u);
+  EXIT_IF_0(SDEInitData(&data, 1));
+  EXIT_IF_0(SDESetDrift(data, DriftGBM));
+  EXIT_IF_0(SDESetDiffusion(data, DiffusionGBM));
+  EXIT_IF_0(SDESetUserData(data, &gbm));
+  EXIT_IF_0(SDESetStep(data, 1./SDE_STEPS));
+  EXIT_IF_0(SDECheck(data));
+  double em = StrongErrorGBM(data, &gbm);
+  double path = SDEGetY(data, 0);
+  EXIT_IF_0(StrongErrorGBM(data, &gbm) == em && SDEGetY(data, 0) == path);
+  EXIT_IF_0(SDESetMethod(data, SDE_MILSTEIN));
+  double milstein = StrongErrorGBM(data, &gbm);
+  EXIT_IF_0(milstein < 0.75*em);
+  EXIT_IF_0(SDESetMethod(data, SDE_SRA1));
+  EXIT_IF_0(SDESetDrift(data, DriftCos));
+  EXIT_IF_0(SDESetDiffusion(data, DiffusionConst));
+  EXIT_IF_0(SDESetStream(data, 42, 0));
+  EXIT_IF_0(SDESetX(data, 0.));
+  EXIT_IF_0(SDESetY0(data, 1., 0));
+  SDEStepN(data, SDE_STEPS);
+  EXIT_IF_0(fabs(SDEGetY(data, 0) - 1. - sin(SDEGetX(data)) -
+                 0.5*SDEGetW(data, 0)) < 1.E-5);
+  SDEFreeData(data);
+  return 1;
+error:
+  SDEFreeData(data);
+  return 0;
+}
+
+#define HEAT_NUM 1000
+
+void ForceHeat(double const x, double *b, void *userdata){
+  for(unsigned i = 0; i < HEAT_NUM; i++){
+    b[i] = 1. + sin(x);
+  }
+}
+
+void RightSideHeat(double const x, double const *y, double *dy,
+                   unsigned const first, unsigned const last,
+                   void *userdata){
+  double n2 = (HEAT_NUM + 1.)*(HEAT_NUM + 1.);
+  for(unsigned i = first; i < last; i++){
+    double l = i ? y[i - 1] : 0.;
+    double r = i + 1 < HEAT_NUM ? y[i + 1] : 0.;
+    dy[i] = n2*(l - 2.*y[i] + r) + 1. + sin(x);
+  }
+}
+
+int TestLinear(void){
+  linear_data *data = NULL;
+  rk_data *rk = NULL;
+  pool_data *pool = NULL;
+  static unsigned row_ptr[HEAT_NUM + 1], cols[3*HEAT_NUM];
+  static double vals[3*HEAT_NUM];
+  double n2 = (HEAT_NUM + 1.)*(HEAT_NUM + 1.);
+  unsigned nnz = 0;
+  for(unsigned i = 0; i < HEAT_NUM; i++){
+    row_ptr[i] = nnz;
+    for(int j = (int)i - 1; j <= (int)i + 1; j++){
+      if(j >= 0 && j < HEAT_NUM){
+        cols[nnz] = j;
+        vals[nnz++] = j == (int)i ? -2.*n2 : n2;
+      }
+    }
+  }
+  row_ptr[HEAT_NUM] = nnz;
+  EXIT_IF_0(PoolInitData(&pool, 3));
+  EXIT_IF_0(LinearInitData(&data, HEAT_NUM));
+  EXIT_IF_0(!LinearSetMatrix(data, row_ptr, NULL, vals));
+  EXIT_IF_0(!LinearSetMatrix(data, row_ptr, cols, NULL));
+  EXIT_IF_0(LinearSetMatrix(data, row_ptr, cols, vals));
+  EXIT_IF_0(LinearSetForce(data, ForceHeat));
+  EXIT_IF_0(LinearSetPool(data, pool));
+  EXIT_IF_0(LinearSetStep(data, 0.2/n2));
+  EXIT_IF_0(LinearCheck(data));
+  EXIT_IF_0(RK4InitData(&rk, HEAT_NUM));
+  EXIT_IF_0(RK4SetRangeSystem(rk, RightSideHeat));
+  EXIT_IF_0(RK4SetStep(rk, 0.2/n2));
+  EXIT_IF_0(RK4Check(rk));
+  LinearStepN(data, 500);
+  RK4StepN(rk, 500);
+  EXIT_IF_0(fabs(LinearGetX(data) - RK4GetX(rk)) < 1.E-15);
+  for(unsigned i = 0; i < HEAT_NUM; i++){
+    EXIT_IF_0(fabs(LinearGetY(data, i) - RK4GetY(rk, i)) < 1.E-12);
+    EXIT_IF_0(fabs(LinearGetDY(data, i) - RK4GetDY(rk, i)) <
+              1.E-9*(1. + fabs(RK4GetDY(rk, i))));
+  }
+  LinearFreeData(data);
+  RK4FreeData(rk);
+  PoolFreeData(pool);
+  return 1;
+error:
+  LinearFreeData(data);
+  RK4FreeData(rk);
+  PoolFreeData(pool);
+  return 0;
+}
+
+void NonlinCos(double const x, double const *y, double *n, void *userdata){
+  n[0] = cos(x);
+  n[1] = cos(x);
+}
+
+#define ETD_NUM 40
+
+void NonlinCubic(double const x, double const *y, double *n,
+                 void *userdata){
+  for(unsigned i = 0; i < ETD_NUM; i++){
+    n[i] = sin(x) - y[i]*y[i]*y[i];
+  }
+}
+
+void NonlinNaN(double const x, double const *y, double *n, void *userdata){
+  for(unsigned i = 0; i < ETD_NUM; i++){
+    n[i] = NAN;
+  }
+}
+
+void MatvecHeat(double const *v, double *lv, void *userdata){
+  double n2 = (ETD_NUM + 1.)*(ETD_NUM + 1.);
+  for(unsigned i = 0; i < ETD_NUM; i++){
+    double l = i ? v[i - 1] : 0.;
+    double r = i + 1 < ETD_NUM ? v[i + 1] : 0.;
+    lv[i] = n2*(l - 2.*v[i] + r);
+  }
+}
+
+int TestETD(void){
+  etd_data *diag = NULL, *dense = NULL, *krylov = NULL;
+  double l[2] = {-1., -1.E4};
+  double ld[4] = {-1., 0., 0., -1.E4};
+  static double lh[ETD_NUM*ETD_NUM];
+  double n2 = (ETD_NUM + 1.)*(ETD_NUM + 1.);
+  EXIT_IF_0(ETDInitData(&diag, 2));
+  EXIT_IF_0(ETDInitData(&dense, 2));
+  EXIT_IF_0(ETDSetDiagonal(diag, l, 2));
+  EXIT_IF_0(ETDSetDense(dense, ld, 4));
+  EXIT_IF_0(ETDSetNonlinear(diag, NonlinCos));
+  EXIT_IF_0(ETDSetNonlinear(dense, NonlinCos));
+  EXIT_IF_0(ETDSetStep(diag, 0.1));
+  EXIT_IF_0(ETDSetStep(dense, 0.1));
+  EXIT_IF_0(ETDCheck(diag));
+  EXIT_IF_0(ETDCheck(dense));
+  ETDStepN(diag, 50);
+  ETDStepN(dense, 50);
+  for(unsigned i = 0; i < 2; i++){
+    /* y' = l y + cos x, y(0) = 0 */
+    double a = -l[i]/(1. + l[i]*l[i]), b = 1./(1. + l[i]*l[i]);
+    double x = ETDGetX(diag);
+    double exact = -a*exp(l[i]*x) + a*cos(x) + b*sin(x);
+    EXIT_IF_0(fabs(ETDGetY(diag, i) - exact) < 1.E-5);
+    EXIT_IF_0(fabs(ETDGetY(dense, i) - ETDGetY(diag, i)) < 1.E-10);
+  }
+  ETDFreeData(diag);
+  ETDFreeData(dense);
+  diag = NULL;
+  dense = NULL;
+  for(unsigned i = 0; i < ETD_NUM; i++){
+    lh[i*ETD_NUM + i] = -2.*n2;
+    if(i){
+      lh[i*ETD_NUM + i - 1] = n2;
+    }
+    if(i + 1 < ETD_NUM){
+      lh[i*ETD_NUM + i + 1] = n2;
+    }
+  }
+  EXIT_IF_0(ETDInitData(&dense, ETD_NUM));
+  EXIT_IF_0(ETDInitData(&krylov, ETD_NUM));
+  EXIT_IF_0(ETDSetDense(dense, lh, ETD_NUM*ETD_NUM));
+  EXIT_IF_0(ETDSetMatvec(krylov, MatvecHeat));
+  EXIT_IF_0(ETDSetNonlinear(dense, NonlinCubic));
+  EXIT_IF_0(ETDSetNonlinear(krylov, NonlinCubic));
+  for(unsigned i = 0; i < ETD_NUM; i++){
+    EXIT_IF_0(ETDSetY0(dense, 1., i));
+    EXIT_IF_0(ETDSetY0(krylov, 1., i));
+  }
+  EXIT_IF_0(ETDSetStep(dense, 0.05));
+  EXIT_IF_0(ETDSetStep(krylov, 0.05));
+  EXIT_IF_0(ETDCheck(dense));
+  EXIT_IF_0(ETDCheck(krylov));
+  ETDStepN(dense, 20);
+  ETDStepN(krylov, 20);
+  for(unsigned i = 0; i < ETD_NUM; i++){
+    EXIT_IF_0(fabs(ETDGetY(dense, i) - ETDGetY(krylov, i)) < 1.E-8);
+  }
+  /* a NaN in the Krylov basis fails the step, the state stays */
+  double x = ETDGetX(krylov), y0 = ETDGetY(krylov, 0);
+  EXIT_IF_0(ETDSetNonlinear(krylov, NonlinNaN));
+  EXIT_IF_0(!ETDStepN(krylov, 2));
+  EXIT_IF_0(ETDGetX(krylov) == x && ETDGetY(krylov, 0) == y0);
+  /* and the exponential of a non-finite operator is not attempted */
+  ld[0] = INFINITY;
+  EXIT_IF_0(ETDInitData(&diag, 2));
+  EXIT_IF_0(ETDSetDense(diag, ld, 4));
+  EXIT_IF_0(ETDSetNonlinear(diag, NonlinCos));
+  EXIT_IF_0(ETDSetStep(diag, 0.1));
+  EXIT_IF_0(!ETDCheck(diag));
+  EXIT_IF_0(!ETDStep(diag));
+  ETDFreeData(diag);
+  ETDFreeData(dense);
+  ETDFreeData(krylov);
+  return 1;
+error:
+  ETDFreeData(diag);
+  ETDFreeData(dense);
+  ETDFreeData(krylov);
+  return 0;
+}
+
+#define RKC_NUM 100
+#define RKC_PI 3.14159265358979323846
+
+void RightSideDiffusion(double const x, double const *y, double *dy,
+                        void *userdata){
+  double n2 = (RKC_NUM + 1.)*(RKC_NUM + 1.);
+  for(unsigned i = 0; i < RKC_NUM; i++){
+    double l = i ? y[i - 1] : 0.;
+    double r = i + 1 < RKC_NUM ? y[i + 1] : 0.;
+    dy[i] = n2*(l - 2.*y[i] + r);
+  }
+}
+
+int TestRKC(void){
+  rkc_data *data = NULL;
+  double n2 = (RKC_NUM + 1.)*(RKC_NUM + 1.);
+  double dx = 1./(RKC_NUM + 1.);
+  /* the lowest mode of the discrete Laplacian decays with rate lambda */
+  double lambda = 4.*n2*sin(0.5*RKC_PI*dx)*sin(0.5*RKC_PI*dx);
+  double rho = 4.*n2*cos(0.5*RKC_PI*dx)*cos(0.5*RKC_PI*dx);
+  EXIT_IF_0(RKCInitData(&data, RKC_NUM));
+  for(unsigned i = 0; i < RKC_NUM; i++){
+    EXIT_IF_0(RKCSetY0(data, sin(RKC_PI*(i + 1)*dx), i));
+  }
+  EXIT_IF_0(RKCSetSystem(data, RightSideDiffusion));
+  EXIT_IF_0(RKCSetStep(data, 0.01));
+  EXIT_IF_0(RKCCheck(data));
+  RKCStepN(data, 10);
+  EXIT_IF_0(RKCGetSpectralRadius(data) > rho &&
+            RKCGetSpectralRadius(data) < 1.3*rho);
+  EXIT_IF_0(RKCGetStages(data) < 40);
+  for(unsigned i = 0; i < RKC_NUM; i++){
+    double exact = exp(-lambda*RKCGetX(data))*sin(RKC_PI*(i + 1)*dx);
+    EXIT_IF_0(fabs(RKCGetY(data, i) - exact) < 5.E-4);
+  }
+  RKCFreeData(data);
+  return 1;
+error:
+  RKCFreeData(data);
+  return 0;
+}
+
+#define RUNNER_JOBS 64
+
+void RightSideRunner(double const x, double const *y, double *dy,
+                     void *userdata){
+  double const *k = userdata;
+  dy[0] = -*k*y[0];
+  dy[1] = *k*y[0];
+}
+
+int StopHalf(double const x, double const *y, void *userdata){
+  return y[0] < 0.5;
+}
+
+int TestRunner(void){
+  runner_data *data = NULL;
+  runner_job jobs[RUNNER_JOBS];
+  double k[RUNNER_JOBS], ys[RUNNER_JOBS][2];
+  double y0[2] = {1., 0.};
+  for(unsigned j = 0; j < RUNNER_JOBS; j++){
+    k[j] = 0.5 + 0.1*j;
+    jobs[j] = (runner_job){.solver = j % RUNNER_SOLVERS, .eq_num = 2,
+                           .y0 = y0, .x0 = 0., .h = STEP,
+                           .x_end = j < RUNNER_JOBS/2 ? 0.1 : 0.1*j,
+                           .func = RightSideRunner,
+                           .stop = j % 3 ? NULL : StopHalf,
+                           .userdata = k + j, .y = ys[j]};
+  }
+  EXIT_IF_0(RunnerInitData(&data, 4));
+  EXIT_IF_0(RunnerRun(data, jobs, RUNNER_JOBS));
+  for(unsigned j = 0; j < RUNNER_JOBS; j++){
+    double exact = exp(-k[j]*jobs[j].x);
+    EXIT_IF_0(jobs[j].status);
+    EXIT_IF_0(fabs(ys[j][0] - exact) < 1.E-9);
+    EXIT_IF_0(fabs(ys[j][0] + ys[j][1] - 1.) < 1.E-12);
+    if(jobs[j].stop && jobs[j].x < jobs[j].x_end){
+      EXIT_IF_0(ys[j][0] < 0.5 && jobs[j].x - log(2.)/k[j] < STEP);
+    } else {
+      EXIT_IF_0(fabs(jobs[j].x - jobs[j].x_end) < 1.E-9);
+    }
+  }
+  /* reused solver objects must not carry state between runs */
+  EXIT_IF_0(RunnerRun(data, jobs, RUNNER_JOBS));
+  EXIT_IF_0(fabs(ys[RUNNER_JOBS - 1][0] -
+                 exp(-k[RUNNER_JOBS - 1]*jobs[RUNNER_JOBS - 1].x)) < 1.E-9);
+  RunnerFreeData(data);
+  return 1;
+error:
+  RunnerFreeData(data);
+  return 0;
+}
+
+#define FORCING_ROWS 10001
+
+double RightSideForced(double const x, double const *y, void *userdata){
+  return ForcingGet(userdata, x, 0);
+}
+
+int TestForcing(void){
+  static double table[2*FORCING_ROWS];
+  forcing_data *mem = NULL, *file = NULL;
+  rk_data *rk = NULL;
+  double err[3] = {0., 0., 0.};
+  enum ForcingInterp interp[3] = {FORCING_LINEAR, FORCING_CUBIC,
+                                  FORCING_AKIMA};
+  for(unsigned i = 0; i < FORCING_ROWS; i++){
+    table[2*i] = 1.E-3*i;
+    table[2*i + 1] = sin(1.E-3*i);
+  }
+  FILE *out = fopen("forcing.bin", "wb");
+  EXIT_IF_0(out);
+  EXIT_IF_0(fwrite(table, sizeof(double), 2*FORCING_ROWS, out) ==
+            2*FORCING_ROWS);
+  fclose(out);
+  EXIT_IF_0(ForcingInitTable(&mem, table, FORCING_ROWS, 1));
+  EXIT_IF_0(ForcingInitFile(&file, "forcing.bin", 1));
+  EXIT_IF_0(ForcingGetRows(file) == FORCING_ROWS);
+  for(unsigned m = 0; m < 3; m++){
+    EXIT_IF_0(ForcingSetInterp(mem, interp[m]));
+    EXIT_IF_0(ForcingSetInterp(file, interp[m]));
+    for(double x = 0.; x < 10.; x += 7.77E-4){
+      double v = ForcingGet(mem, x, 0);
+      EXIT_IF_0(v == ForcingGet(file, x, 0));
+      err[m] = fmax(err[m], fabs(v - sin(x)));
+    }
+    /* jumping back must find the segment as well */
+    EXIT_IF_0(fabs(ForcingGet(mem, 0.5, 0) - sin(0.5)) < 1.E-6);
+  }
+  EXIT_IF_0(err[0] < 2.E-7 && err[1] < 2.E-8 && err[2] < 1.E-9);
+  EXIT_IF_0(ForcingSetInterp(mem, FORCING_CUBIC));
+  EXIT_IF_0(RK4InitData(&rk, 1));
+  EXIT_IF_0(RK4SetEquation(rk, RightSideForced, 0));
+  EXIT_IF_0(RK4SetUserData(rk, mem));
+  EXIT_IF_0(RK4SetStep(rk, 1.E-2));
+  EXIT_IF_0(RK4Check(rk));
+  RK4StepN(rk, 900);
+  EXIT_IF_0(fabs(RK4GetY(rk, 0) - 1. + cos(RK4GetX(rk))) < 1.E-7);
+  RK4FreeData(rk);
+  ForcingFreeData(mem);
+  ForcingFreeData(file);
+  return 1;
+error:
+  RK4FreeData(rk);
+  ForcingFreeData(mem);
+  ForcingFreeData(file);
+  return 0;
+}
+
+/* Resonant two level system, i psi' = Omega/2 sigma_x psi. */
+double complex RightSideRabi0(double const x, double complex const *y,
+                              void *userdata){
+  double const *omega = userdata;
+  return -I*0.5**omega*y[1];
+}
+
+double complex RightSideRabi1(double const x, double complex const *y,
+                              void *userdata){
+  double const *omega = userdata;
+  return -I*0.5**omega*y[0];
+}
+
+void RightSideRabi(double const x, double complex const *y,
+                   double complex *dy, void *userdata){
+  dy[0] = RightSideRabi0(x, y, userdata);
+  dy[1] = RightSideRabi1(x, y, userdata);
+}
+
+int TestComplex(void){
+  crk4_data *rk4 = NULL;
+  crk5_data *rk5 = NULL;
+  double omega = 2.;
+  double complex psi0[2] = {1., 0.};
+  CRK4RSFunc funcs[2] = {RightSideRabi0, RightSideRabi1};
+  EXIT_IF_0(CRK4InitData(&rk4, 2));
+  EXIT_IF_0(CRK5InitData(&rk5, 2));
+  EXIT_IF_0(CRK4SetYs0(rk4, psi0, 2));
+  EXIT_IF_0(CRK5SetYs0(rk5, psi0, 2));
+  EXIT_IF_0(CRK4SetEquations(rk4, funcs, 2));
+  EXIT_IF_0(CRK5SetSystem(rk5, RightSideRabi));
+  EXIT_IF_0(CRK4SetUserData(rk4, &omega));
+  EXIT_IF_0(CRK5SetUserData(rk5, &omega));
+  EXIT_IF_0(CRK4SetStep(rk4, STEP));
+  EXIT_IF_0(CRK5SetStep(rk5, STEP));
+  EXIT_IF_0(CRK4Check(rk4));
+  EXIT_IF_0(CRK5Check(rk5));
+  CRK4StepN(rk4, 5000);
+  CRK5StepN(rk5, 5000);
+  double t = CRK5GetX(rk5);
+  double complex exact[2] = {cos(0.5*omega*t), -I*sin(0.5*omega*t)};
+  for(unsigned i = 0; i < 2; i++){
+    EXIT_IF_0(cabs(CRK4GetY(rk4, i) - exact[i]) < 1.E-10);
+    EXIT_IF_0(cabs(CRK5GetY(rk5, i) - exact[i]) < 1.E-10);
+  }
+  CRK4FreeData(rk4);
+  CRK5FreeData(rk5);
+  return 1;
+error:
+  CRK4FreeData(rk4);
+  CRK5FreeData(rk5);
+  return 0;
+}
+
+#define TRAJ_EQ 200
+#define TRAJ_STEPS 500
+
+/* Swaps the uint64 at fseek position (at, whence) with *value. */
+int SwapTrajWord(char const *path, long const at, int const whence,
+                 uint64_t *value){
+  FILE *file = fopen(path, "r+b");
+  uint64_t old = 0;
+  int ok = file && !fseek(file, at, whence) &&
+           fread(&old, sizeof(old), 1, file) == 1 &&
+           !fseek(file, at, whence) &&
+           fwrite(value, sizeof(*value), 1, file) == 1;
+  if(file){
+    ok = !fclose(file) && ok;
+  }
+  *value = old;
+  return ok;
+}
+
+int TestTraj(void){
+  static double rows[TRAJ_STEPS][TRAJ_EQ];
+  traj_data *out = NULL, *in = NULL;
+  double x, ys[TRAJ_EQ];
+  for(unsigned s = 0; s < TRAJ_STEPS; s++){
+    for(unsigned i = 0; i < TRAJ_EQ; i++){
+      rows[s][i] = sin(STEP*s*(1. + 1.E-2*i)) + i;
+    }
+  }
+  EXIT_IF_0(TrajInitWriter(&out, "traj.bin", TRAJ_EQ, 64, 3));
+  for(unsigned s = 0; s < TRAJ_STEPS; s++){
+    EXIT_IF_0(TrajPush(out, STEP*s, rows[s]));
+  }
+  EXIT_IF_0(TrajClose(out));
+  TrajFreeData(out);
+  out = NULL;
+  FILE *file = fopen("traj.bin", "rb");
+  EXIT_IF_0(file);
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fclose(file);
+  EXIT_IF_0(size < (long)(3*sizeof(rows) / 4));
+  EXIT_IF_0(TrajInitReader(&in, "traj.bin"));
+  EXIT_IF_0(TrajGetEqNum(in) == TRAJ_EQ);
+  EXIT_IF_0(TrajGetSteps(in) == TRAJ_STEPS);
+  /* out of order, across blocks and into the short last one */
+  for(unsigned k = 0; k < TRAJ_STEPS; k++){
+    unsigned s = (k*317u) % TRAJ_STEPS;
+    EXIT_IF_0(TrajRead(in, s, &x, ys));
+    EXIT_IF_0(x == STEP*s);
+    EXIT_IF_0(!memcmp(ys, rows[s], sizeof(ys)));
+  }
+  EXIT_IF_0(!TrajRead(in, TRAJ_STEPS, &x, ys));
+  TrajFreeData(in);
+  in = NULL;
+  /* footers that disagree with the index are rejected: more steps than
+   * the blocks hold, more blocks than fit in the file, and a short
+   * first block even when the steps add up */
+  uint64_t patch = TRAJ_STEPS + 64, index = 0, count = 63;
+  EXIT_IF_0(SwapTrajWord("traj.bin", -24, SEEK_END, &patch));
+  EXIT_IF_0(!TrajInitReader(&in, "traj.bin"));
+  EXIT_IF_0(SwapTrajWord("traj.bin", -24, SEEK_END, &patch));
+  patch = UINT64_MAX / 8;
+  EXIT_IF_0(SwapTrajWord("traj.bin", -32, SEEK_END, &patch));
+  EXIT_IF_0(!TrajInitReader(&in, "traj.bin"));
+  EXIT_IF_0(SwapTrajWord("traj.bin", -32, SEEK_END, &patch));
+  EXIT_IF_0(SwapTrajWord("traj.bin", -40, SEEK_END, &index));
+  patch = index;
+  EXIT_IF_0(SwapTrajWord("traj.bin", -40, SEEK_END, &patch));
+  patch = TRAJ_STEPS - 1;
+  EXIT_IF_0(SwapTrajWord("traj.bin", (long)index + 16, SEEK_SET, &count));
+  EXIT_IF_0(SwapTrajWord("traj.bin", -24, SEEK_END, &patch));
+  EXIT_IF_0(!TrajInitReader(&in, "traj.bin"));
+  EXIT_IF_0(SwapTrajWord("traj.bin", (long)index + 16, SEEK_SET, &count));
+  EXIT_IF_0(SwapTrajWord("traj.bin", -24, SEEK_END, &patch));
+  EXIT_IF_0(TrajInitReader(&in, "traj.bin"));
+  TrajFreeData(in);
+  return 1;
+error:
+  TrajFreeData(out);
+  TrajFreeData(in);
+  return 0;
+}
+
+int TestAutotune(void){
+  autotune_data *data = NULL;
+  runner_data *runner = NULL;
+  autotune_result best, cached, c;
+  struct user_data ud = {4., 1.};
+  double y0[EQUATIONS_NUM] = {0., 1.}, y[EQUATIONS_NUM];
+  runner_job problem = {.eq_num = EQUATIONS_NUM, .y0 = y0, .x0 = 0.,
+                        .x_end = 20., .func = RightSide, .userdata = &ud};
+  remove("autotune.cache");
+  EXIT_IF_0(AutotuneInitData(&data));
+  EXIT_IF_0(AutotuneSetCache(data, "autotune.cache"));
+  EXIT_IF_0(AutotuneRun(data, &problem, "spring", 1.E-7, &best));
+  EXIT_IF_0(!AutotuneGetCached(data));
+  /* every candidate's step must really meet the target on the span */
+  EXIT_IF_0(RunnerInitData(&runner, 1));
+  for(unsigned s = 0; s < RUNNER_SOLVERS; s++){
+    EXIT_IF_0(AutotuneGetCandidate(data, s, &c));
+    EXIT_IF_0(c.seconds >= best.seconds && c.evals > 0);
+    runner_job job = problem;
+    job.solver = s;
+    job.h = c.h;
+    job.y = y;
+    EXIT_IF_0(RunnerRun(runner, &job, 1));
+    EXIT_IF_0(fabs(y[X] - cos(2.*job.x)) < 1.E-7);
+  }
+  EXIT_IF_0(AutotuneRun(data, &problem, "spring", 1.E-7, &cached));
+  EXIT_IF_0(AutotuneGetCached(data));
+  EXIT_IF_0(cached.solver == best.solver && cached.h == best.h);
+  /* a looser target affords a larger step */
+  EXIT_IF_0(AutotuneRun(data, &problem, "spring", 1.E-4, &c));
+  EXIT_IF_0(!AutotuneGetCached(data));
+  EXIT_IF_0(AutotuneGetCandidate(data, best.solver, &c));
+  EXIT_IF_0(c.h > best.h);
+  RunnerFreeData(runner);
+  AutotuneFreeData(data);
+  return 1;
+error:
+  RunnerFreeData(runner);
+  AutotuneFreeData(data);
+  return 0;
+}
+
 int main(int argc, char *argv[]){
-  return !(TestAdams() && TestRK4() && TestRK5() && TestAdams5());
+  return !(TestAdams() && TestRK4() && TestRK5() && TestAdams5() &&
+           TestRK4Multirate() && TestParareal() && TestGBS() &&
+           TestObserver() && TestObserverPolicies() && TestSystem() &&
+           TestSens() && TestDDE() && TestDDEDelays() && TestRKN() &&
+           TestRK4Threads() && TestPoolAffinity() && TestSDE() && TestLinear() &&
+           TestETD() && TestRKC() && TestRunner() &&
+           TestForcing() && TestComplex() && TestTraj() &&
+           TestAutotune());
 }
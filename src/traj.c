@@ -0,0 +1,422 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include "stdlib.h"
+#include "string.h"
+#include "stdint.h"
+#include "sys/types.h"
+#include "traj.h"
+#include "pool.h"
+
+/* Block encoding. Every value of a step is XORed with the same value of
+ * the previous step of the block (the first step with 0), so slowly
+ * varying components leave only low mantissa bits set. The XORed words
+ * are then byte shuffled: byte plane p of all words of the block, in
+ * component-major order, is stored contiguously, which turns the
+ * unchanged sign, exponent and high mantissa bytes into long zero runs.
+ * The planes are finally zero-run encoded with one token byte:
+ *   0x00 - 0x7F  t + 1 literal bytes follow
+ *   0x80 - 0xFE  (t & 0x7F) + 1 zero bytes
+ *   0xFF         a LEB128 count of zero bytes follows
+ * Blocks depend on nothing outside them, which is what allows both the
+ * parallel compression and the random access.
+ *
+ * File layout (native byte order): "TRAJ0001", eq_num, block_steps as
+ * uint32, the blocks, the index of (offset, size, steps) uint64 triples
+ * and a 40 byte footer: index offset, blocks, steps as uint64, eq_num,
+ * block_steps as uint32 and "TRAJINDX". */
+
+struct traj_block_st{
+  uint64_t *raw;
+  unsigned char *shuf;
+  unsigned char *out;
+  unsigned steps;
+  size_t size;
+};
+
+struct traj_data_st{
+  FILE *file;
+  int writer;
+  unsigned eq_num;
+  unsigned width;
+  unsigned block_steps;
+  size_t steps;
+  pool_data *pool;
+  unsigned slots;
+  unsigned filled;
+  struct traj_block_st *blocks;
+  uint64_t *index;
+  size_t blocks_num;
+  size_t index_cap;
+  off_t offset;
+  int failed;
+  unsigned char *in;
+  unsigned char *shuf;
+  uint64_t *rows;
+  size_t cached;
+};
+
+#define EXIT_IF_NULL(POINTER) if( NULL == POINTER ){ goto error; }
+
+#define TRAJ_MAGIC "TRAJ0001"
+#define TRAJ_INDEX_MAGIC "TRAJINDX"
+#define TRAJ_HEADER 16
+#define TRAJ_FOOTER 40
+
+static size_t TrajBound(size_t const n){
+  return n + n / 128 + 16;
+}
+
+static size_t TrajRLE(unsigned char const *in, size_t const n,
+                      unsigned char *out){
+  size_t i = 0, o = 0;
+  while(i < n){
+    size_t z = i;
+    while(z < n && !in[z]){
+      z++;
+    }
+    size_t zeros = z - i;
+    if(zeros >= 2){
+      if(zeros <= 127){
+        out[o++] = (unsigned char)(0x80 | (zeros - 1));
+      } else {
+        out[o++] = 0xFF;
+        while(zeros >= 0x80){
+          out[o++] = (unsigned char)(0x80 | (zeros & 0x7F));
+          zeros >>= 7;
+        }
+        out[o++] = (unsigned char)zeros;
+      }
+      i = z;
+      continue;
+    }
+    size_t start = i;
+    while(i < n && i - start < 128 &&
+          !(i + 1 < n && !in[i] && !in[i + 1])){
+      i++;
+    }
+    out[o++] = (unsigned char)(i - start - 1);
+    memcpy(out + o, in + start, i - start);
+    o += i - start;
+  }
+  return o;
+}
+
+static int TrajUnRLE(unsigned char const *in, size_t const size,
+                     unsigned char *out, size_t const n){
+  size_t i = 0, o = 0;
+  while(i < size){
+    unsigned t = in[i++];
+    size_t len;
+    if(t < 0x80){
+      len = t + 1;
+      if(i + len > size || o + len > n){
+        return 0;
+      }
+      memcpy(out + o, in + i, len);
+      i += len;
+    } else {
+      if(0xFF == t){
+        unsigned shift = 0;
+        len = 0;
+        do{
+          if(i >= size || shift > 56){
+            return 0;
+          }
+          len |= (size_t)(in[i] & 0x7F) << shift;
+          shift += 7;
+        }while(in[i++] & 0x80);
+      } else {
+        len = (t & 0x7F) + 1;
+      }
+      if(o + len > n){
+        return 0;
+      }
+      memset(out + o, 0, len);
+    }
+    o += len;
+  }
+  return o == n;
+}
+
+static void TrajCompressTask(unsigned const task, unsigned const thread,
+                             void *arg){
+  traj_data *data = arg;
+  struct traj_block_st *block = data->blocks + task;
+  unsigned w = data->width, steps = block->steps;
+  size_t total = (size_t)steps*w;
+  for(unsigned c = 0; c < w; c++){
+    uint64_t prev = 0;
+    for(unsigned r = 0; r < steps; r++){
+      uint64_t v = block->raw[(size_t)r*w + c];
+      uint64_t d = v ^ prev;
+      size_t at = (size_t)c*steps + r;
+      prev = v;
+      for(unsigned p = 0; p < 8; p++){
+        block->shuf[p*total + at] = (unsigned char)(d >> (8*p));
+      }
+    }
+  }
+  block->size = TrajRLE(block->shuf, 8*total, block->out);
+}
+
+static void TrajWrite(traj_data *data, void const *buf, size_t const size){
+  if(size && fwrite(buf, 1, size, data->file) != size){
+    data->failed = 1;
+  }
+}
+
+/* Compresses the first `count` slots on the pool and appends them. */
+static void TrajFlush(traj_data *data, unsigned const count){
+  PoolRun(data->pool, TrajCompressTask, count, data);
+  for(unsigned b = 0; b < count; b++){
+    struct traj_block_st *block = data->blocks + b;
+    if(data->blocks_num == data->index_cap){
+      size_t cap = data->index_cap ? 2*data->index_cap : 64;
+      uint64_t *index = realloc(data->index, sizeof(uint64_t)*3*cap);
+      if(!index){
+        data->failed = 1;
+        return;
+      }
+      data->index = index;
+      data->index_cap = cap;
+    }
+    uint64_t *entry = data->index + 3*data->blocks_num++;
+    entry[0] = data->offset;
+    entry[1] = block->size;
+    entry[2] = block->steps;
+    TrajWrite(data, block->out, block->size);
+    data->offset += block->size;
+    block->steps = 0;
+  }
+  data->filled = 0;
+}
+
+int TrajInitWriter(traj_data **data, char const *path, unsigned const eq_num,
+                   unsigned const block_steps, unsigned const threads){
+  if(!eq_num || !block_steps){
+    return 0;
+  }
+  *data = calloc(1, sizeof(traj_data));
+  EXIT_IF_NULL(*data);
+  (*data)->writer = 1;
+  (*data)->eq_num = eq_num;
+  (*data)->width = eq_num + 1;
+  (*data)->block_steps = block_steps;
+  (*data)->slots = threads ? threads : 1;
+  (*data)->blocks = calloc((*data)->slots, sizeof(struct traj_block_st));
+  EXIT_IF_NULL((*data)->blocks);
+  size_t values = (size_t)block_steps*(*data)->width;
+  for(unsigned s = 0; s < (*data)->slots; s++){
+    struct traj_block_st *block = (*data)->blocks + s;
+    block->raw = malloc(sizeof(uint64_t)*values);
+    EXIT_IF_NULL(block->raw);
+    block->shuf = malloc(8*values);
+    EXIT_IF_NULL(block->shuf);
+    block->out = malloc(TrajBound(8*values));
+    EXIT_IF_NULL(block->out);
+  }
+  if(!PoolInitData(&(*data)->pool, (*data)->slots)){
+    goto error;
+  }
+  (*data)->file = fopen(path, "wb");
+  EXIT_IF_NULL((*data)->file);
+  uint32_t header[2] = {eq_num, block_steps};
+  TrajWrite(*data, TRAJ_MAGIC, 8);
+  TrajWrite(*data, header, sizeof(header));
+  (*data)->offset = TRAJ_HEADER;
+  return !(*data)->failed;
+error:
+  TrajFreeData(*data);
+  *data = NULL;
+  return 0;
+}
+
+int TrajPush(traj_data *data, double const x, double const *ys){
+  if(!data || !data->writer || !data->file || !ys){
+    return 0;
+  }
+  struct traj_block_st *block = data->blocks + data->filled;
+  uint64_t *row = block->raw + (size_t)block->steps*data->width;
+  memcpy(row, &x, sizeof(double));
+  memcpy(row + 1, ys, sizeof(double)*data->eq_num);
+  data->steps++;
+  if(++block->steps == data->block_steps &&
+     ++data->filled == data->slots){
+    TrajFlush(data, data->slots);
+  }
+  return !data->failed;
+}
+
+int TrajClose(traj_data *data){
+  if(!data || !data->writer || !data->file){
+    return 0;
+  }
+  unsigned count = data->filled;
+  if(count < data->slots && data->blocks[count].steps){
+    count++;
+  }
+  if(count){
+    TrajFlush(data, count);
+  }
+  uint64_t footer[3] = {data->offset, data->blocks_num, data->steps};
+  uint32_t sizes[2] = {data->eq_num, data->block_steps};
+  TrajWrite(data, data->index, sizeof(uint64_t)*3*data->blocks_num);
+  TrajWrite(data, footer, sizeof(footer));
+  TrajWrite(data, sizes, sizeof(sizes));
+  TrajWrite(data, TRAJ_INDEX_MAGIC, 8);
+  if(fclose(data->file)){
+    data->failed = 1;
+  }
+  data->file = NULL;
+  return !data->failed;
+}
+
+int TrajInitReader(traj_data **data, char const *path){
+  uint64_t footer[3];
+  uint32_t sizes[2];
+  char magic[8];
+  off_t end;
+  *data = calloc(1, sizeof(traj_data));
+  EXIT_IF_NULL(*data);
+  (*data)->file = fopen(path, "rb");
+  EXIT_IF_NULL((*data)->file);
+  if(fseeko((*data)->file, -TRAJ_FOOTER, SEEK_END) ||
+     (end = ftello((*data)->file)) < 0 ||
+     fread(footer, sizeof(footer), 1, (*data)->file) != 1 ||
+     fread(sizes, sizeof(sizes), 1, (*data)->file) != 1 ||
+     fread(magic, 8, 1, (*data)->file) != 1 ||
+     memcmp(magic, TRAJ_INDEX_MAGIC, 8) || !sizes[0] || !sizes[1]){
+    goto error;
+  }
+  /* the index lies before the footer, which also bounds its allocation */
+  if(footer[0] > (uint64_t)end ||
+     footer[1] > ((uint64_t)end - footer[0]) / (sizeof(uint64_t)*3) ||
+     footer[1] >= SIZE_MAX / (sizeof(uint64_t)*3)){
+    goto error;
+  }
+  (*data)->eq_num = sizes[0];
+  (*data)->width = sizes[0] + 1;
+  (*data)->block_steps = sizes[1];
+  (*data)->blocks_num = footer[1];
+  (*data)->steps = footer[2];
+  (*data)->cached = (size_t)-1;
+  (*data)->index = malloc(sizeof(uint64_t)*3*((*data)->blocks_num + 1));
+  EXIT_IF_NULL((*data)->index);
+  if(fseeko((*data)->file, (off_t)footer[0], SEEK_SET) ||
+     fread((*data)->index, sizeof(uint64_t)*3, (*data)->blocks_num,
+           (*data)->file) != (*data)->blocks_num){
+    goto error;
+  }
+  size_t values = (size_t)(*data)->block_steps*(*data)->width;
+  size_t in_size = 0;
+  uint64_t steps = 0;
+  /* TrajRead maps step s to block s / block_steps: all blocks but the
+   * last must be full */
+  for(size_t b = 0; b < (*data)->blocks_num; b++){
+    uint64_t *entry = (*data)->index + 3*b;
+    if(!entry[2] || entry[2] > (*data)->block_steps ||
+       (b + 1 < (*data)->blocks_num && entry[2] != (*data)->block_steps) ||
+       entry[1] > TrajBound(8*values)){
+      goto error;
+    }
+    steps += entry[2];
+    in_size = entry[1] > in_size ? entry[1] : in_size;
+  }
+  if(steps != footer[2]){
+    goto error;
+  }
+  (*data)->in = malloc(in_size + 1);
+  EXIT_IF_NULL((*data)->in);
+  (*data)->shuf = malloc(8*values);
+  EXIT_IF_NULL((*data)->shuf);
+  (*data)->rows = malloc(sizeof(uint64_t)*values);
+  EXIT_IF_NULL((*data)->rows);
+  return 1;
+error:
+  TrajFreeData(*data);
+  *data = NULL;
+  return 0;
+}
+
+static int TrajLoad(traj_data *data, size_t const b){
+  uint64_t const *entry = data->index + 3*b;
+  unsigned w = data->width, steps = (unsigned)entry[2];
+  size_t total = (size_t)steps*w;
+  data->cached = (size_t)-1;
+  if(fseeko(data->file, (off_t)entry[0], SEEK_SET) ||
+     fread(data->in, 1, entry[1], data->file) != entry[1] ||
+     !TrajUnRLE(data->in, entry[1], data->shuf, 8*total)){
+    return 0;
+  }
+  for(unsigned c = 0; c < w; c++){
+    uint64_t prev = 0;
+    for(unsigned r = 0; r < steps; r++){
+      size_t at = (size_t)c*steps + r;
+      uint64_t d = 0;
+      for(unsigned p = 0; p < 8; p++){
+        d |= (uint64_t)data->shuf[p*total + at] << (8*p);
+      }
+      prev ^= d;
+      data->rows[(size_t)r*w + c] = prev;
+    }
+  }
+  data->cached = b;
+  return 1;
+}
+
+int TrajRead(traj_data *data, size_t const step, double *x, double *ys){
+  if(!data || data->writer || step >= data->steps){
+    return 0;
+  }
+  size_t b = step / data->block_steps;
+  if(b != data->cached && !TrajLoad(data, b)){
+    return 0;
+  }
+  uint64_t const *row = data->rows +
+                        (size_t)(step % data->block_steps)*data->width;
+  if(x){
+    memcpy(x, row, sizeof(double));
+  }
+  if(ys){
+    memcpy(ys, row + 1, sizeof(double)*data->eq_num);
+  }
+  return 1;
+}
+
+unsigned TrajGetEqNum(traj_data *data){
+  if(data){
+    return data->eq_num;
+  }
+  return 0;
+}
+
+size_t TrajGetSteps(traj_data *data){
+  if(data){
+    return data->steps;
+  }
+  return 0;
+}
+
+void TrajFreeData(traj_data *data){
+  if(data){
+    if(data->writer && data->file){
+      TrajClose(data);
+    } else if(data->file){
+      fclose(data->file);
+    }
+    PoolFreeData(data->pool);
+    if(data->blocks){
+      for(unsigned s = 0; s < data->slots; s++){
+        free(data->blocks[s].raw);
+        free(data->blocks[s].shuf);
+        free(data->blocks[s].out);
+      }
+    }
+    free(data->blocks);
+    free(data->index);
+    free(data->in);
+    free(data->shuf);
+    free(data->rows);
+    free(data);
+  }
+}